@@ -39,12 +39,12 @@ SOURCES=$(list "
 ")
 
 LIBS=$(list "
-    -lcircbuf_static
     -lhashmap_static
     -lsparse_static
     -ldynarr_static
     -lvector_static
     -lm
+    -lpthread
 ")
 
 init_subdirs() {
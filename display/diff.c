@@ -0,0 +1,175 @@
+#include "diff.h"
+
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#   define DIFF_X86
+#   include <immintrin.h>
+#endif
+
+#define BLOCK_CELLS 64 /* cells covered by one change mask */
+
+typedef uint64_t cell_t;
+
+typedef uint64_t (*mask_kernel_t)(const cell_t *a, const cell_t *b, size_t length);
+
+static uint64_t mask_scalar(const cell_t *a, const cell_t *b, size_t length);
+#ifdef DIFF_X86
+__attribute__((target("sse2"))) static uint64_t mask_sse2(const cell_t *a, const cell_t *b, size_t length);
+__attribute__((target("avx2"))) static uint64_t mask_avx2(const cell_t *a, const cell_t *b, size_t length);
+#endif
+static mask_kernel_t select_kernel(void);
+static size_t append_runs(uint64_t mask, const size_t offset, disp_run_t runs[], size_t count);
+
+static mask_kernel_t g_kernel = NULL;
+
+
+size_t disp_row_diff(const void *const a, const void *const b,
+        const size_t length, disp_run_t runs[])
+{
+    const cell_t *const x = a;
+    const cell_t *const y = b;
+
+    if (!g_kernel) g_kernel = select_kernel();
+
+    size_t count = 0;
+    for (size_t offset = 0; offset < length; offset += BLOCK_CELLS)
+    {
+        const size_t block = (length - offset < BLOCK_CELLS) ? length - offset : BLOCK_CELLS;
+        const uint64_t mask = g_kernel(x + offset, y + offset, block);
+        if (mask) count = append_runs(mask, offset, runs, count);
+    }
+    return count;
+}
+
+
+bool disp_diff_select(const disp_diff_kernel_t kernel)
+{
+#ifdef DIFF_X86
+    __builtin_cpu_init();
+#endif
+    switch (kernel)
+    {
+        case DISP_DIFF_AUTO:
+            g_kernel = select_kernel();
+            return true;
+
+        case DISP_DIFF_SCALAR:
+            g_kernel = mask_scalar;
+            return true;
+
+#ifdef DIFF_X86
+        case DISP_DIFF_SSE2:
+            if (!__builtin_cpu_supports("sse2")) return false;
+            g_kernel = mask_sse2;
+            return true;
+
+        case DISP_DIFF_AVX2:
+            if (!__builtin_cpu_supports("avx2")) return false;
+            g_kernel = mask_avx2;
+            return true;
+#endif
+
+        default:
+            return false;
+    }
+}
+
+
+/*
+* Each kernel returns a mask of at most 64 cells,
+* bit is set when cell differs.
+*/
+static uint64_t mask_scalar(const cell_t *a, const cell_t *b, size_t length)
+{
+    uint64_t mask = 0;
+    for (size_t i = 0; i < length; ++i)
+    {
+        uint64_t x, y;
+        memcpy(&x, &a[i], sizeof(x));
+        memcpy(&y, &b[i], sizeof(y));
+        mask |= (uint64_t)(x != y) << i;
+    }
+    return mask;
+}
+
+
+#ifdef DIFF_X86
+/* two cells per 16 bytes, cell is equal when all 8 of its byte lanes are */
+__attribute__((target("sse2")))
+static uint64_t mask_sse2(const cell_t *a, const cell_t *b, size_t length)
+{
+    uint64_t mask = 0;
+    size_t i = 0;
+    for (; i + 2 <= length; i += 2)
+    {
+        const __m128i x = _mm_loadu_si128((const __m128i *)(a + i));
+        const __m128i y = _mm_loadu_si128((const __m128i *)(b + i));
+        const unsigned int eq = _mm_movemask_epi8(_mm_cmpeq_epi32(x, y));
+        const uint64_t changed = (0xFF != (eq & 0xFF)) | ((uint64_t)(0xFF != (eq >> 8)) << 1);
+        mask |= changed << i;
+    }
+    if (i < length) mask |= mask_scalar(a + i, b + i, length - i) << i;
+    return mask;
+}
+
+
+/* four cells per 32 bytes */
+__attribute__((target("avx2")))
+static uint64_t mask_avx2(const cell_t *a, const cell_t *b, size_t length)
+{
+    uint64_t mask = 0;
+    size_t i = 0;
+    for (; i + 4 <= length; i += 4)
+    {
+        const __m256i x = _mm256_loadu_si256((const __m256i *)(a + i));
+        const __m256i y = _mm256_loadu_si256((const __m256i *)(b + i));
+        const __m256i eq = _mm256_cmpeq_epi64(x, y);
+        const uint64_t changed = ~_mm256_movemask_pd(_mm256_castsi256_pd(eq)) & 0xF;
+        mask |= changed << i;
+    }
+    if (i < length) mask |= mask_sse2(a + i, b + i, length - i) << i;
+    return mask;
+}
+#endif
+
+
+static mask_kernel_t select_kernel(void)
+{
+#ifdef DIFF_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return mask_avx2;
+    if (__builtin_cpu_supports("sse2")) return mask_sse2;
+#endif
+    return mask_scalar;
+}
+
+
+/* Turns set bits into runs, merging with the last run when it touches the block */
+static size_t append_runs(uint64_t mask, const size_t offset, disp_run_t runs[], size_t count)
+{
+    size_t bit = 0;
+    while (mask)
+    {
+        const unsigned int skip = __builtin_ctzll(mask);
+        mask >>= skip;
+        bit += skip;
+
+        const unsigned int len = (~mask) ? __builtin_ctzll(~mask) : 64;
+        const size_t first = offset + bit;
+        const size_t end = first + len;
+
+        if (count && runs[count - 1].end == first)
+        {
+            runs[count - 1].end = end;
+        }
+        else
+        {
+            runs[count++] = (disp_run_t){ .first = first, .end = end };
+        }
+
+        mask = (len < 64) ? mask >> len : 0;
+        bit += len;
+    }
+    return count;
+}
@@ -0,0 +1,43 @@
+#ifndef _DIFF_H_
+#define _DIFF_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Changed cells of a row: [first, end) */
+typedef struct
+{
+    uint16_t first;
+    uint16_t end;
+}
+disp_run_t;
+
+typedef enum
+{
+    DISP_DIFF_AUTO = 0, /* the widest one the cpu supports */
+    DISP_DIFF_SCALAR,
+    DISP_DIFF_SSE2,
+    DISP_DIFF_AVX2,
+}
+disp_diff_kernel_t;
+
+/* Row of `length` cells can't have more runs than that */
+#define DISP_MAX_RUNS(length) (((length) + 1) / 2)
+
+/*
+* Compares two rows of 8 byte cells (see disp_char_t)
+* and stores changed runs into `runs`,
+* which must hold at least DISP_MAX_RUNS(length) entries.
+* Returns amount of runs found.
+*/
+size_t disp_row_diff(const void *const a, const void *const b,
+        const size_t length, disp_run_t runs[]);
+
+/*
+* Picks the comparison kernel, the automatic one is picked on the first diff.
+* Returns false when the cpu can't run it, the kernel stays as it was.
+*/
+bool disp_diff_select(const disp_diff_kernel_t kernel);
+
+#endif/*_DIFF_H_*/
@@ -0,0 +1,104 @@
+#include "diff.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+* Every kernel the cpu runs is checked against a cell by cell comparison,
+* on rows of all lengths around the block and vector widths.
+*/
+
+#define MAX_LENGTH 200
+
+static const char *const kernel_names[] = {
+    [DISP_DIFF_SCALAR] = "scalar",
+    [DISP_DIFF_SSE2]   = "sse2",
+    [DISP_DIFF_AVX2]   = "avx2",
+};
+
+static uint64_t a[MAX_LENGTH];
+static uint64_t b[MAX_LENGTH];
+
+
+static size_t reference_diff(const size_t length, disp_run_t runs[])
+{
+    size_t count = 0;
+    for (size_t i = 0; i < length; ++i)
+    {
+        if (a[i] == b[i]) continue;
+        if (count && runs[count - 1].end == i) ++runs[count - 1].end;
+        else runs[count++] = (disp_run_t){ .first = i, .end = i + 1 };
+    }
+    return count;
+}
+
+
+static void expect_same(const size_t length)
+{
+    disp_run_t expected[DISP_MAX_RUNS(MAX_LENGTH)];
+    disp_run_t actual[DISP_MAX_RUNS(MAX_LENGTH)];
+
+    const size_t count = reference_diff(length, expected);
+    const size_t found = disp_row_diff(a, b, length, actual);
+    assert(count == found);
+    assert(0 == memcmp(expected, actual, count * sizeof(disp_run_t)));
+}
+
+
+/* Flips one byte of the cell, so that only a part of its lanes differ */
+static void touch(const size_t cell)
+{
+    ((unsigned char *)&b[cell])[rand() % sizeof(uint64_t)] ^= 1 + rand() % 255;
+}
+
+
+static void check_length(const size_t length)
+{
+    for (size_t i = 0; i < length; ++i)
+    {
+        a[i] = b[i] = ((uint64_t)rand() << 32) | (uint64_t)rand();
+    }
+    expect_same(length);
+
+    if (!length) return;
+
+    touch(length - 1); /* last cell is where the tail handling is */
+    expect_same(length);
+
+    touch(0);
+    expect_same(length);
+
+    for (size_t i = 0; i < length; ++i)
+    {
+        if (rand() % 3) touch(i);
+    }
+    expect_same(length);
+
+    for (size_t i = 0; i < length; ++i)
+    {
+        b[i] = ~a[i];
+    }
+    expect_same(length);
+}
+
+
+int main(void)
+{
+    srand(1);
+    for (disp_diff_kernel_t kernel = DISP_DIFF_SCALAR; kernel <= DISP_DIFF_AVX2; ++kernel)
+    {
+        if (!disp_diff_select(kernel))
+        {
+            printf("%s: not supported, skipped\n", kernel_names[kernel]);
+            continue;
+        }
+        for (size_t length = 0; length <= MAX_LENGTH; ++length)
+        {
+            check_length(length);
+        }
+        printf("%s: ok\n", kernel_names[kernel]);
+    }
+    return EXIT_SUCCESS;
+}
@@ -2,29 +2,122 @@
 
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <sys/ioctl.h>
+#include <sys/signalfd.h>
 #include <signal.h>
+#include <unistd.h>
 #include <assert.h>
 #include <stdarg.h>
 #include "layout.h"
 
+_Static_assert(sizeof(disp_char_t) == 8, "row diff compares cells as 8 byte words");
+
 static int prev_buffer(const int active);
-static bool disp_diff(const disp_char_t *const a, const disp_char_t *const b);
-static void display_swap_buffers(display_t *const display);
+static void damage_span(display_t *const display, const unsigned int line,
+        const unsigned int first, const unsigned int last);
+static bool is_on_screen(const display_t *const display, const disp_pos_t pos);
+static disp_char_t *buffer_row(const display_t *const display, const int buffer, const unsigned int line);
 static disp_pos_t get_terminal_size(void);
-static void set_border(display_t *const display, wchar_t border_char, disp_pos_t pos, style_t style);
+static void set_border(display_t *const display, wchar_t border_char, disp_pos_t pos, disp_style_id_t style);
+static void put_cell(display_t *const display, const disp_pos_t pos, const wint_t ch, const disp_style_id_t style);
+static void render_run(display_t *const display, const disp_char_t *const run,
+        const unsigned int length, const disp_pos_t pos);
+static void render_style(display_t *const display, const disp_style_id_t style);
+static void present_scroll(display_t *const display, const disp_area_t area);
+static void scroll_region(display_t *const display, const unsigned int top, const unsigned int bottom,
+        const unsigned int left, const unsigned int right, const int shift);
+
+void display_init(display_t *const display)
+{
+    *display = (display_t){
+        .active = 0,
+        .sgr = SGR_DEFAULT_STATE,
+    };
+    disp_styles_init(&display->styles);
+    disp_out_init(&display->out, DISP_OUT_INITIAL_CAP);
+    display_resize(display, get_terminal_size());
+}
+
 
-struct resize_handler
+void display_deinit(display_t *const display)
 {
-    bool resize_detected;
-    resize_hook_with_data_t resize_hook;
+    for (int b = 0; b < DISP_BUFFERS; ++b)
+    {
+        free(display->buffers[b]);
+    }
+    free(display->damage);
+    free(display->runs);
+    free(display->hashes);
+    disp_styles_deinit(&display->styles);
+    disp_out_deinit(&display->out);
 }
-volatile g_resize_handler;
 
-static void resize_handler(int signo, siginfo_t *info, void *ctx)
+
+/*
+* Reallocates buffers to the new terminal size.
+* Content of the active buffer is kept where it still fits,
+* previous one is zeroed, so that everything is printed again.
+*/
+void display_resize(display_t *const display, const disp_pos_t size)
 {
-    (void) signo; (void) info; (void) ctx;
-    g_resize_handler.resize_detected = true;
+    if (display->damage && disp_pos_equal(display->size, size)) return;
+
+    /* at least one of each, so that zero sized terminal is not a failure */
+    const size_t cells = (size_t)size.x * size.y + 1;
+    const size_t rows = (size_t)size.y + 1;
+    const int prev = prev_buffer(display->active);
+
+    disp_char_t *active = malloc(cells * sizeof(disp_char_t));
+    disp_char_t *previous = calloc(cells, sizeof(disp_char_t));
+    disp_damage_t *damage = malloc(rows * sizeof(disp_damage_t));
+    disp_run_t *runs = malloc(DISP_MAX_RUNS(size.x + 1) * sizeof(disp_run_t));
+    uint64_t *hashes = malloc(2 * rows * sizeof(uint64_t));
+    if (!active || !previous || !damage || !runs || !hashes)
+    {
+        perror("display_resize");
+        exit(EXIT_FAILURE);
+    }
+
+    for (unsigned int line = 0; line < size.y; ++line)
+    {
+        disp_char_t *row = &active[line * size.x];
+        unsigned int kept = 0;
+        if (line < display->size.y && display->buffers[display->active])
+        {
+            kept = (size.x < display->size.x) ? size.x : display->size.x;
+            memcpy(row, buffer_row(display, display->active, line), kept * sizeof(disp_char_t));
+        }
+        for (unsigned int col = kept; col < size.x; ++col)
+        {
+            row[col] = (disp_char_t){ .ch = U' ' };
+        }
+        damage[line] = (disp_damage_t){0, size.x ? size.x - 1 : 0};
+    }
+
+    free(display->buffers[display->active]);
+    free(display->buffers[prev]);
+    free(display->damage);
+    free(display->runs);
+    free(display->hashes);
+
+    display->buffers[display->active] = active;
+    display->buffers[prev] = previous;
+    display->damage = damage;
+    display->runs = runs;
+    display->hashes = hashes;
+    display->size = size;
+    display->reprint = true; /* terminal may have reflowed what it shows */
+}
+
+
+/*
+* Terminals that support DECLRMM can scroll content of a panel
+* that doesn't span the whole width, for the rest only full rows are scrolled.
+*/
+void display_set_lr_margins(display_t *const display, const bool supported)
+{
+    display->lr_margins = supported;
 }
 
 
@@ -52,105 +145,164 @@ void display_leave_alternate_screen(void)
 }
 
 
-void display_set_resize_handler(display_t *const display, resize_hook_with_data_t resize_hook)
+/*
+* Blocks SIGWINCH and returns a signalfd that becomes readable on it,
+* so that resizes are picked up by the event loop instead of a handler.
+*/
+int display_open_resize_fd(void)
+{
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGWINCH);
+    if (-1 == sigprocmask(SIG_BLOCK, &mask, NULL))
+    {
+        perror("sigprocmask");
+        exit(EXIT_FAILURE);
+    }
+
+    const int fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (-1 == fd)
+    {
+        perror("signalfd");
+        exit(EXIT_FAILURE);
+    }
+    return fd;
+}
+
+
+/* Follows the terminal size, returns true if it has changed */
+bool display_sync_size(display_t *const display)
 {
-    g_resize_handler.resize_hook = resize_hook;
-    struct sigaction action = {0};
-    action.sa_sigaction = resize_handler;
-    sigaction(SIGWINCH, &action, NULL);
-    display->size = get_terminal_size();
-    printf(CLEAR);
+    const disp_pos_t size = get_terminal_size();
+    if (disp_pos_equal(display->size, size)) return false;
+
+    display_resize(display, size);
+    return true;
 }
 
 
 void display_render(display_t *const display)
 {
-    disp_pos_t screen = get_terminal_size();
     disp_area_t screen_area = {
         .second = {
-            .x = screen.x - 1,
-            .y = screen.y - 1
+            .x = display->size.x - 1,
+            .y = display->size.y - 1
         }
     };
 
     display_render_area(display, screen_area);
 
-    fflush(stdout);
+    fflush(stdout); /* keep order with anything printed through stdio */
+    (void) disp_out_flush(&display->out, STDOUT_FILENO);
 }
 
 
 void display_render_area(display_t *const display, disp_area_t area)
 {
-    int prev = prev_buffer(display->active);
-    dispbuf_ptr_t active = display->buffers[display->active];
-    dispbuf_ptr_t previous = display->buffers[prev];
+    const int prev = prev_buffer(display->active);
 
-    bool force_reprint = false;
-    if (g_resize_handler.resize_detected)
-    {
-        display->size = get_terminal_size();
+    const bool force_reprint = display->reprint;
+    display->reprint = false;
 
-        volatile resize_hook_with_data_t *resize_hook = &g_resize_handler.resize_hook;
-        resize_hook->hook(display, resize_hook->data);
+    if (!force_reprint) present_scroll(display, area);
 
-        force_reprint = true;
-        g_resize_handler.resize_detected = false;
-    }
+    const unsigned int end_col = (area.second.x < display->size.x)
+        ? area.second.x + 1
+        : display->size.x;
 
     for (unsigned int line = area.first.y;
             line <= area.second.y && line < display->size.y;
             ++line)
     {
-        for (unsigned int col = area.first.x;
-                col <= area.second.x && col < display->size.x;
-                ++col)
+        const disp_char_t *const active = buffer_row(display, display->active, line);
+        disp_char_t *const previous = buffer_row(display, prev, line);
+        disp_damage_t *const damage = &display->damage[line];
+
+        /* only damaged part of the row can differ from the terminal */
+        unsigned int col = area.first.x;
+        unsigned int span_end = end_col;
+        if (!force_reprint)
+        {
+            if (damage->first > col) col = damage->first;
+            if (damage->last + 1u < span_end) span_end = damage->last + 1;
+        }
+
+        size_t count = 0;
+        if (col < span_end && force_reprint)
         {
-            if (force_reprint
-                || disp_diff(&active[line][col], &previous[line][col]))
-            {
-                if (active[line][col].style.seq)
-                    printf("%s", active[line][col].style.seq);
-                printf(ESC"[%d;%dH%lc", line + 1, col + 1, active[line][col].ch);
-                printf(ESC RESET_STYLE);
-            }
+            display->runs[count++] = (disp_run_t){ .first = 0, .end = span_end - col };
+        }
+        else if (col < span_end)
+        {
+            count = disp_row_diff(&active[col], &previous[col], span_end - col, display->runs);
+        }
+
+        for (size_t r = 0; r < count; ++r)
+        {
+            const unsigned int first = col + display->runs[r].first;
+            const unsigned int length = display->runs[r].end - display->runs[r].first;
+
+            render_run(display, &active[first], length, (disp_pos_t){.x = first, .y = line});
+
+            /* previous buffer mirrors what terminal shows */
+            memcpy(&previous[first], &active[first], length * sizeof(disp_char_t));
+        }
+
+        if (area.first.x <= damage->first && damage->last < end_col)
+        {
+            *damage = NO_DAMAGE;
         }
     }
 
-    display_swap_buffers(display);
+    /* leave terminal in default state for anything printed outside of frames */
+    render_style(display, DISP_STYLE_DEFAULT);
 }
 
 
 void display_set_char(display_t *const display, wint_t ch, disp_pos_t pos)
 {
-    display->buffers[display->active][pos.y][pos.x].ch = ch;
+    if (!is_on_screen(display, pos)) return;
+
+    buffer_row(display, display->active, pos.y)[pos.x].ch = ch;
+    damage_span(display, pos.y, pos.x, pos.x);
 }
 
 
 void display_set_style(display_t *const display, style_t style, disp_pos_t pos)
 {
-    display->buffers[display->active][pos.y][pos.x].style = style;
+    if (!is_on_screen(display, pos)) return;
+
+    buffer_row(display, display->active, pos.y)[pos.x].style = display_style_id(display, style);
+    damage_span(display, pos.y, pos.x, pos.x);
+}
+
+
+disp_style_id_t display_style_id(display_t *const display, style_t style)
+{
+    return disp_styles_intern(&display->styles, style.seq);
 }
 
 
 void display_draw_border(display_t *const display, style_t style, border_set_t border, disp_area_t area)
 {
+    const disp_style_id_t id = display_style_id(display, style);
     for (unsigned int y = area.first.y; y <= area.second.y; ++y)
     {
         for (unsigned int x = area.first.x; x <= area.second.x; ++x)
         {
             disp_pos_t pos = {x, y};
             if (x == area.first.x && y == area.first.y)
-                set_border(display, border.top_left, pos, style);
+                set_border(display, border.top_left, pos, id);
             else if (x == area.second.x && y == area.first.y)
-                set_border(display, border.top_right, pos, style);
+                set_border(display, border.top_right, pos, id);
             else if (x == area.second.x && y == area.second.y)
-                set_border(display, border.bot_right, pos, style);
+                set_border(display, border.bot_right, pos, id);
             else if (x == area.first.x && y == area.second.y)
-                set_border(display, border.bot_left, pos, style);
+                set_border(display, border.bot_left, pos, id);
             else if (x == area.first.x || x == area.second.x)
-                set_border(display, border.vertical, pos, style);
+                set_border(display, border.vertical, pos, id);
             else if (y == area.first.y || y == area.second.y)
-                set_border(display, border.horizontal, pos, style);
+                set_border(display, border.horizontal, pos, id);
         }
     }
 }
@@ -158,13 +310,12 @@ void display_draw_border(display_t *const display, style_t style, border_set_t b
 
 void display_fill_area(display_t *const display, style_t style, disp_area_t area)
 {
+    const disp_style_id_t id = display_style_id(display, style);
     for (unsigned int y = area.first.y; y <= area.second.y; ++y)
     {
         for (unsigned int x = area.first.x; x <= area.second.x; ++x)
         {
-            disp_pos_t pos = {x, y};
-            display_set_style(display, style, pos);
-            display_set_char(display, U' ', pos);
+            put_cell(display, (disp_pos_t){x, y}, U' ', id);
         }
     }
 }
@@ -172,10 +323,20 @@ void display_fill_area(display_t *const display, style_t style, disp_area_t area
 
 void display_draw_string(display_t *const display, unsigned int size, const char string[size], disp_pos_t pos, style_t style)
 {
+    const disp_style_id_t id = display_style_id(display, style);
+    for (unsigned int i = 0; i < size; ++i, ++pos.x)
+    {
+        put_cell(display, pos, (unsigned char)string[i], id);
+    }
+}
+
+
+void display_draw_codepoints(display_t *const display, unsigned int size, const uint32_t text[size], disp_pos_t pos, style_t style)
+{
+    const disp_style_id_t id = display_style_id(display, style);
     for (unsigned int i = 0; i < size; ++i, ++pos.x)
     {
-        display_set_char(display, string[i], pos);
-        display_set_style(display, style, pos);
+        put_cell(display, pos, text[i], id);
     }
 }
 
@@ -299,10 +460,21 @@ void display_draw_string_aligned(display_t *const display,
 // }
 
 
-static void set_border(display_t *const display, wchar_t border_char, disp_pos_t pos, style_t style)
+static void set_border(display_t *const display, wchar_t border_char, disp_pos_t pos, disp_style_id_t style)
+{
+    put_cell(display, pos, border_char, style);
+}
+
+
+static void put_cell(display_t *const display, const disp_pos_t pos, const wint_t ch, const disp_style_id_t style)
 {
-    display_set_style(display, style, pos);
-    display_set_char(display, border_char, pos);
+    if (!is_on_screen(display, pos)) return;
+
+    buffer_row(display, display->active, pos.y)[pos.x] = (disp_char_t){
+        .ch = ch,
+        .style = style,
+    };
+    damage_span(display, pos.y, pos.x, pos.x);
 }
 
 
@@ -326,19 +498,22 @@ void display_clear(display_t *const display)
 
 void display_clear_area(display_t *const display, disp_area_t area)
 {
-    dispbuf_ptr_t active = display->buffers[display->active];
+    const unsigned int end_col = (area.second.x < display->size.x)
+        ? area.second.x + 1
+        : display->size.x;
 
     for (unsigned int line = area.first.y;
             line <= area.second.y && line < display->size.y;
             ++line)
     {
-        for (unsigned int col = area.first.x;
-                col <= area.second.x && col < display->size.x;
-                ++col)
+        if (area.first.x >= end_col) break;
+
+        disp_char_t *const active = buffer_row(display, display->active, line);
+        for (unsigned int col = area.first.x; col < end_col; ++col)
         {
-            active[line][col].style = (style_t){ 0 };
-            active[line][col].ch = U' ';
+            active[col] = (disp_char_t){ .ch = U' ', .style = DISP_STYLE_DEFAULT };
         }
+        damage_span(display, line, area.first.x, end_col - 1);
     }
 }
 
@@ -382,24 +557,240 @@ size_t disp_area_width(disp_area_t area)
 }
 
 
+/* Bounding box of both */
+disp_area_t disp_area_union(disp_area_t a, disp_area_t b)
+{
+    if (IS_INVALID_AREA(&a)) return b;
+    if (IS_INVALID_AREA(&b)) return a;
+
+    return (disp_area_t){
+        .first = {
+            .x = a.first.x < b.first.x ? a.first.x : b.first.x,
+            .y = a.first.y < b.first.y ? a.first.y : b.first.y,
+        },
+        .second = {
+            .x = a.second.x > b.second.x ? a.second.x : b.second.x,
+            .y = a.second.y > b.second.y ? a.second.y : b.second.y,
+        },
+    };
+}
+
+
+disp_area_t disp_area_intersection(disp_area_t a, disp_area_t b)
+{
+    if (IS_INVALID_AREA(&a) || IS_INVALID_AREA(&b)) return INVALID_AREA;
+
+    const disp_area_t common = {
+        .first = {
+            .x = a.first.x > b.first.x ? a.first.x : b.first.x,
+            .y = a.first.y > b.first.y ? a.first.y : b.first.y,
+        },
+        .second = {
+            .x = a.second.x < b.second.x ? a.second.x : b.second.x,
+            .y = a.second.y < b.second.y ? a.second.y : b.second.y,
+        },
+    };
+
+    if (common.first.x > common.second.x || common.first.y > common.second.y)
+    {
+        return INVALID_AREA;
+    }
+    return common;
+}
+
+
 static int prev_buffer(const int active)
 {
     return (active + DISP_BUFFERS - 1) % DISP_BUFFERS;
 }
 
-static bool disp_diff(const disp_char_t *const a, const disp_char_t *const b)
+/*
+* Moves the cursor once to the beginning of the run,
+* then writes all of its cells, terminal advances the cursor by itself.
+*/
+static void render_run(display_t *const display, const disp_char_t *const run,
+        const unsigned int length, const disp_pos_t pos)
 {
-    return memcmp(a, b, sizeof(disp_char_t));
+    disp_out_t *const out = &display->out;
+
+    disp_out_bytes(out, ESC"[", 2);
+    disp_out_uint(out, pos.y + 1);
+    disp_out_bytes(out, ";", 1);
+    disp_out_uint(out, pos.x + 1);
+    disp_out_bytes(out, "H", 1);
+
+    for (unsigned int i = 0; i < length; ++i)
+    {
+        render_style(display, run[i].style);
+        disp_out_utf8(out, run[i].ch ? run[i].ch : U' ');
+    }
 }
 
-static void display_swap_buffers(display_t *const display)
+
+/*
+* Emits only the transition from the style terminal currently has.
+*/
+static void render_style(display_t *const display, const disp_style_id_t style)
+{
+    const sgr_state_t *const state = disp_styles_sgr(&display->styles, style);
+
+    char seq[SGR_SEQ_MAX_SIZE];
+    const size_t size = sgr_transition(&display->sgr, state, seq);
+    if (size)
+    {
+        disp_out_bytes(&display->out, seq, size);
+        display->sgr = *state;
+    }
+}
+
+
+/*
+* Bounds changed cells of the area, and when their content moved vertically
+* scrolls it on the terminal. Previous buffer is shifted the same way,
+* so that the diff repaints only rows that were exposed.
+*/
+static void present_scroll(display_t *const display, const disp_area_t area)
+{
+    const int prev = prev_buffer(display->active);
+    const unsigned int end_col = (area.second.x < display->size.x)
+        ? area.second.x + 1
+        : display->size.x;
+
+    unsigned int top = display->size.y, bottom = 0;
+    unsigned int left = display->size.x, right = 0;
+
+    for (unsigned int line = area.first.y;
+            line <= area.second.y && line < display->size.y;
+            ++line)
+    {
+        const disp_damage_t damage = display->damage[line];
+        const unsigned int col = (damage.first > area.first.x) ? damage.first : area.first.x;
+        const unsigned int span_end = (damage.last + 1u < end_col) ? damage.last + 1u : end_col;
+        if (col >= span_end) continue;
+
+        const size_t count = disp_row_diff(&buffer_row(display, display->active, line)[col],
+                &buffer_row(display, prev, line)[col], span_end - col, display->runs);
+        if (!count) continue;
+
+        if (line < top) top = line;
+        bottom = line;
+        if (col + display->runs[0].first < left) left = col + display->runs[0].first;
+        if (col + display->runs[count - 1].end > right) right = col + display->runs[count - 1].end;
+    }
+
+    if (top > bottom) return;
+
+    if (!display->lr_margins)
+    {
+        /* static columns at the sides (borders mostly) usually line up as well */
+        left = 0;
+        right = display->size.x;
+    }
+
+    const disp_region_t region = {
+        .active = &buffer_row(display, display->active, top)[left],
+        .previous = &buffer_row(display, prev, top)[left],
+        .stride = display->size.x,
+        .width = right - left,
+        .height = bottom - top + 1,
+    };
+
+    const int shift = disp_detect_shift(&region, display->hashes);
+    if (shift)
+    {
+        scroll_region(display, top, bottom, left, right, shift);
+    }
+}
+
+
+/*
+* Scrolls rows [top, bottom] within columns [left, right) by `shift`,
+* positive one moves content up.
+*/
+static void scroll_region(display_t *const display, const unsigned int top, const unsigned int bottom,
+        const unsigned int left, const unsigned int right, const int shift)
+{
+    disp_out_t *const out = &display->out;
+    const bool margins = left > 0 || right < display->size.x;
+    const unsigned int amount = (shift > 0) ? shift : -shift;
+
+    /* exposed rows are erased with the current background */
+    render_style(display, DISP_STYLE_DEFAULT);
+
+    if (margins)
+    {
+        disp_out_bytes(out, LR_MARGINS_ON, sizeof(LR_MARGINS_ON) - 1);
+        disp_out_bytes(out, ESC"[", 2);
+        disp_out_uint(out, left + 1);
+        disp_out_bytes(out, ";", 1);
+        disp_out_uint(out, right);
+        disp_out_bytes(out, "s", 1);
+    }
+
+    disp_out_bytes(out, ESC"[", 2);
+    disp_out_uint(out, top + 1);
+    disp_out_bytes(out, ";", 1);
+    disp_out_uint(out, bottom + 1);
+    disp_out_bytes(out, "r" ESC "[", 3);
+    disp_out_uint(out, amount);
+    disp_out_bytes(out, (shift > 0) ? "S" : "T", 1); /* SU : SD */
+
+    disp_out_bytes(out, RESET_SCROLL_REGION, sizeof(RESET_SCROLL_REGION) - 1);
+    if (margins)
+    {
+        disp_out_bytes(out, LR_MARGINS_OFF, sizeof(LR_MARGINS_OFF) - 1);
+    }
+
+    /* do the same to the model of the terminal */
+    const int prev = prev_buffer(display->active);
+    const size_t width = (right - left) * sizeof(disp_char_t);
+    for (unsigned int i = 0; i + amount <= bottom - top; ++i)
+    {
+        const unsigned int dst = (shift > 0) ? top + i : bottom - i;
+        const unsigned int src = (shift > 0) ? dst + amount : dst - amount;
+        memcpy(&buffer_row(display, prev, dst)[left], &buffer_row(display, prev, src)[left], width);
+    }
+    for (unsigned int i = 0; i < amount; ++i)
+    {
+        const unsigned int line = (shift > 0) ? bottom - i : top + i;
+        disp_char_t *const row = buffer_row(display, prev, line);
+        for (unsigned int col = left; col < right; ++col)
+        {
+            row[col] = (disp_char_t){ .ch = U' ' };
+        }
+    }
+
+    /* rows that were not touched in this frame may now differ as well */
+    for (unsigned int line = top; line <= bottom; ++line)
+    {
+        damage_span(display, line, left, right - 1);
+    }
+}
+
+
+static void damage_span(display_t *const display, const unsigned int line,
+        const unsigned int first, const unsigned int last)
+{
+    disp_damage_t *const damage = &display->damage[line];
+    if (first < damage->first) damage->first = first;
+    if (last > damage->last) damage->last = last;
+}
+
+
+static bool is_on_screen(const display_t *const display, const disp_pos_t pos)
+{
+    return pos.x < display->size.x && pos.y < display->size.y;
+}
+
+
+static disp_char_t *buffer_row(const display_t *const display, const int buffer, const unsigned int line)
 {
-    display->active = (display->active + 1) % DISP_BUFFERS;
+    return &display->buffers[buffer][line * display->size.x];
 }
 
 static disp_pos_t get_terminal_size(void)
 {
-    struct winsize w;
+    struct winsize w = {0};
     ioctl(0, TIOCGWINSZ, &w);
     return (disp_pos_t){w.ws_col, w.ws_row};
 }
@@ -3,14 +3,17 @@
 
 #include "display_types.h"
 #include "border.h"
+#include "diff.h"
+#include "scroll.h"
 #include "layout.h"
+#include "output.h"
+#include "sgr.h"
+#include "styles.h"
 #include <wchar.h>
 
 #include <stdbool.h>
 
 #define DISP_BUFFERS 2
-#define DISP_MAX_WIDTH 256
-#define DISP_MAX_HEIGHT 256
 
 #define ESC         "\x1b"
 #define HOME        ESC "[H"
@@ -24,34 +27,55 @@
 #define ALTER_SCREEN  ESC "[?1049h"
 #define NORMAL_SCREEN ESC "[?1049l"
 
+#define LR_MARGINS_ON       ESC "[?69h" /* DECLRMM, enables DECSLRM */
+#define LR_MARGINS_OFF      ESC "[?69l"
+#define RESET_SCROLL_REGION ESC "[r"
+
 typedef struct
 {
     const char *seq;
 }
 style_t;
 
+/* Single screen cell, packed into 8 bytes */
 typedef struct
 {
-    style_t style;
-    wchar_t ch;
+    uint32_t        ch;    /* unicode codepoint */
+    disp_style_id_t style; /* id interned in display's style registry */
+    uint16_t        flags; /* reserved for per-cell attributes, kept zero */
 }
 disp_char_t;
-typedef disp_char_t (*dispbuf_ptr_t)[DISP_MAX_WIDTH];
+
+/* Columns of a row written since it was presented last time */
+typedef struct
+{
+    uint16_t first;
+    uint16_t last;
+}
+disp_damage_t;
+
+#define NO_DAMAGE ((disp_damage_t){(uint16_t) -1, 0})
 
 typedef struct display
 {
-    disp_char_t buffers[DISP_BUFFERS][DISP_MAX_HEIGHT][DISP_MAX_WIDTH];
-    int active; /* index of the active buffer */
+    disp_char_t *buffers[DISP_BUFFERS]; /* `size.y` rows of `size.x` cells each */
+    disp_damage_t *damage;              /* one per row */
+    disp_run_t *runs;                   /* changed runs of a row being presented */
+    uint64_t *hashes;                   /* two per row, scratch for scroll detection */
+    bool lr_margins; /* terminal can scroll a part of the row (DECSLRM) */
+    bool reprint;    /* next render prints everything, set by resize */
+    int active; /* index of the buffer that is drawn into, other one mirrors the terminal */
     disp_pos_t size;
+    disp_styles_t styles;
+    sgr_state_t sgr; /* graphic rendition the terminal currently has */
+    disp_out_t out;  /* encoded frame, written at once */
 }
 display_t;
 
-typedef struct
-{
-    void *data;
-    void (*hook) (const display_t *const display, void *data);
-}
-resize_hook_with_data_t;
+void display_init(display_t *const display);
+void display_deinit(display_t *const display);
+void display_resize(display_t *const display, const disp_pos_t size);
+void display_set_lr_margins(display_t *const display, const bool supported);
 
 void display_hide_cursor(void);
 void display_show_cursor(void);
@@ -67,6 +91,9 @@ void
 display_set_style(display_t *const display,
         style_t style,
         disp_pos_t pos);
+disp_style_id_t
+display_style_id(display_t *const display,
+        style_t style);
 void
 display_draw_border(display_t *const display,
         style_t style,
@@ -83,6 +110,12 @@ display_draw_string(display_t *const display,
         disp_pos_t pos,
         style_t style);
 void
+display_draw_codepoints(display_t *const display,
+        unsigned int size,
+        const uint32_t text[size],
+        disp_pos_t pos,
+        style_t style);
+void
 display_draw_string_centered(display_t *const display,
         unsigned int size,
         const char string[size],
@@ -107,9 +140,8 @@ void
 display_clear_area(display_t *const display,
         disp_area_t area);
 
-void 
-display_set_resize_handler(display_t *const display,
-                           resize_hook_with_data_t resize_hook);
+int display_open_resize_fd(void);
+bool display_sync_size(display_t *const display);
 
 void display_clear(display_t *const display);
 bool disp_pos_equal(disp_pos_t a, disp_pos_t b);
@@ -118,6 +150,10 @@ disp_area_t normalized_area(disp_area_t area);
 size_t disp_area_height(disp_area_t area);
 size_t disp_area_width(disp_area_t area);
 
+/* Invalid area is an empty one */
+disp_area_t disp_area_union(disp_area_t a, disp_area_t b);
+disp_area_t disp_area_intersection(disp_area_t a, disp_area_t b);
+
 void display_erase(void);
 
 #endif//_DISPLAY_H_
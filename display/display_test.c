@@ -3,20 +3,14 @@
 #include <termio.h>
 #include <unistd.h>
 
-void resize_hook(const display_t *const display, void *data)
-{
-    (void) display;
-    (void) data;
-}
-
 int main(void)
 {
-    resize_hook_with_data_t hook = {.hook = resize_hook};
     display_t display;
+    display_init(&display);
     input_enable_mouse();
-    display_set_resize_handler(&display, hook);
     while (1)
     {
+        display_sync_size(&display);
         display_clear(&display);
         for (unsigned int i = 0; i < display.size.y; ++i)
         {
@@ -29,5 +23,6 @@ int main(void)
         display_render(&display);
     }
     input_disable_mouse();
+    display_deinit(&display);
     return 0;
 }
@@ -0,0 +1,143 @@
+#include "output.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define UTF8_MAX_SIZE 4
+#define UINT_MAX_DIGITS 10
+
+static void reserve(disp_out_t *const out, const size_t amount);
+
+
+void disp_out_init(disp_out_t *const out, const size_t capacity)
+{
+    *out = (disp_out_t){
+        .data = malloc(capacity),
+        .capacity = capacity,
+    };
+
+    if (!out->data)
+    {
+        perror("disp_out_init");
+        exit(EXIT_FAILURE);
+    }
+}
+
+
+void disp_out_deinit(disp_out_t *const out)
+{
+    free(out->data);
+    *out = (disp_out_t){0};
+}
+
+
+void disp_out_bytes(disp_out_t *const out, const char *const bytes, const size_t size)
+{
+    reserve(out, size);
+    memcpy(out->data + out->size, bytes, size);
+    out->size += size;
+}
+
+
+void disp_out_uint(disp_out_t *const out, unsigned int value)
+{
+    char digits[UINT_MAX_DIGITS];
+    size_t n = 0;
+    do
+    {
+        digits[n++] = '0' + value % 10;
+        value /= 10;
+    }
+    while (value);
+
+    reserve(out, n);
+    while (n) out->data[out->size++] = digits[--n];
+}
+
+
+void disp_out_utf8(disp_out_t *const out, uint32_t codepoint)
+{
+    reserve(out, UTF8_MAX_SIZE);
+    char *p = out->data + out->size;
+
+    if (codepoint > 0x10FFFF || (0xD800 <= codepoint && codepoint <= 0xDFFF))
+    {
+        codepoint = 0xFFFD; /* replacement character */
+    }
+
+    if (codepoint < 0x80)
+    {
+        p[0] = codepoint;
+        out->size += 1;
+    }
+    else if (codepoint < 0x800)
+    {
+        p[0] = 0xC0 | (codepoint >> 6);
+        p[1] = 0x80 | (codepoint & 0x3F);
+        out->size += 2;
+    }
+    else if (codepoint < 0x10000)
+    {
+        p[0] = 0xE0 | (codepoint >> 12);
+        p[1] = 0x80 | ((codepoint >> 6) & 0x3F);
+        p[2] = 0x80 | (codepoint & 0x3F);
+        out->size += 3;
+    }
+    else
+    {
+        p[0] = 0xF0 | (codepoint >> 18);
+        p[1] = 0x80 | ((codepoint >> 12) & 0x3F);
+        p[2] = 0x80 | ((codepoint >> 6) & 0x3F);
+        p[3] = 0x80 | (codepoint & 0x3F);
+        out->size += 4;
+    }
+}
+
+
+int disp_out_flush(disp_out_t *const out, const int fd)
+{
+    size_t written = 0;
+    while (written < out->size)
+    {
+        ssize_t bytes = write(fd, out->data + written, out->size - written);
+        if (-1 == bytes)
+        {
+            if (EINTR == errno) continue;
+            if (EAGAIN == errno || EWOULDBLOCK == errno)
+            {
+                /* another process sharing the tty may have set O_NONBLOCK
+                   on the file description, wait until it drains */
+                struct pollfd pfd = { .fd = fd, .events = POLLOUT };
+                (void) poll(&pfd, 1, -1);
+                continue;
+            }
+            out->size = 0;
+            return errno;
+        }
+        written += bytes;
+    }
+    out->size = 0;
+    return 0;
+}
+
+
+static void reserve(disp_out_t *const out, const size_t amount)
+{
+    if (out->size + amount <= out->capacity) return;
+
+    size_t capacity = out->capacity ? out->capacity : DISP_OUT_INITIAL_CAP;
+    while (capacity < out->size + amount) capacity *= 2;
+
+    char *data = realloc(out->data, capacity);
+    if (!data)
+    {
+        perror("disp_out_reserve");
+        exit(EXIT_FAILURE);
+    }
+    out->data = data;
+    out->capacity = capacity;
+}
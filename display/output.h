@@ -0,0 +1,32 @@
+#ifndef _OUTPUT_H_
+#define _OUTPUT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+* Reusable byte buffer the whole frame is encoded into,
+* so that it reaches the terminal with a single write.
+*/
+
+#define DISP_OUT_INITIAL_CAP 64*1024 // 64kb
+
+typedef struct
+{
+    char   *data;
+    size_t size;
+    size_t capacity;
+}
+disp_out_t;
+
+void disp_out_init(disp_out_t *const out, const size_t capacity);
+void disp_out_deinit(disp_out_t *const out);
+
+void disp_out_bytes(disp_out_t *const out, const char *const bytes, const size_t size);
+void disp_out_uint(disp_out_t *const out, unsigned int value);
+void disp_out_utf8(disp_out_t *const out, uint32_t codepoint);
+
+/* Writes whole content to `fd` and empties the buffer, returns errno on failure */
+int disp_out_flush(disp_out_t *const out, const int fd);
+
+#endif/*_OUTPUT_H_*/
@@ -0,0 +1,86 @@
+#include "scroll.h"
+
+#include <string.h>
+
+typedef uint64_t cell_t;
+
+static const cell_t *region_row(const void *const first, const size_t stride, const size_t row);
+static uint64_t row_hash(const cell_t *const row, const size_t width);
+static size_t count_matches(const disp_region_t *const region, const uint64_t ah[], const uint64_t ph[],
+        const int shift);
+
+
+int disp_detect_shift(const disp_region_t *const region, uint64_t hashes[])
+{
+    const size_t height = region->height;
+    if (height < SCROLL_MIN_ROWS + 1 || 0 == region->width) return 0;
+
+    uint64_t *const ah = hashes;
+    uint64_t *const ph = hashes + height;
+    for (size_t r = 0; r < height; ++r)
+    {
+        ah[r] = row_hash(region_row(region->active, region->stride, r), region->width);
+        ph[r] = row_hash(region_row(region->previous, region->stride, r), region->width);
+    }
+
+    /* rows that are fine as they are, scrolling has to beat that */
+    size_t best_matched = count_matches(region, ah, ph, 0);
+    int best = 0;
+
+    /* shift larger than a half can't line up the majority of rows */
+    const int max_shift = height / 2;
+    for (int shift = 1; shift <= max_shift; ++shift)
+    {
+        const size_t up = count_matches(region, ah, ph, shift);
+        if (up > best_matched) { best_matched = up; best = shift; }
+
+        const size_t down = count_matches(region, ah, ph, -shift);
+        if (down > best_matched) { best_matched = down; best = -shift; }
+    }
+
+    if (best_matched < SCROLL_MIN_ROWS || best_matched * 2 < height) return 0;
+    return best;
+}
+
+
+static const cell_t *region_row(const void *const first, const size_t stride, const size_t row)
+{
+    return (const cell_t *)first + row * stride;
+}
+
+
+static uint64_t row_hash(const cell_t *const row, const size_t width)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < width; ++i)
+    {
+        uint64_t cell;
+        memcpy(&cell, &row[i], sizeof(cell));
+        hash = (hash ^ cell) * 0x100000001b3ULL;
+        hash ^= hash >> 29;
+    }
+    return hash;
+}
+
+
+/* Hashes only filter candidates, equality is confirmed on the cells */
+static size_t count_matches(const disp_region_t *const region, const uint64_t ah[], const uint64_t ph[],
+        const int shift)
+{
+    const size_t height = region->height;
+    const size_t first = (shift < 0) ? (size_t)-shift : 0;
+    const size_t end = (shift > 0) ? height - shift : height;
+
+    size_t matched = 0;
+    for (size_t r = first; r < end; ++r)
+    {
+        if (ah[r] != ph[r + shift]) continue;
+        if (0 == memcmp(region_row(region->active, region->stride, r),
+                    region_row(region->previous, region->stride, r + shift),
+                    region->width * sizeof(cell_t)))
+        {
+            ++matched;
+        }
+    }
+    return matched;
+}
@@ -0,0 +1,33 @@
+#ifndef _SCROLL_H_
+#define _SCROLL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+* Detection of content that moved vertically between two frames,
+* so that terminal can scroll it instead of having it printed again.
+*/
+
+#define SCROLL_MIN_ROWS 2 /* less than that is cheaper to repaint */
+
+/* Rectangle of 8 byte cells (see disp_char_t) in both buffers */
+typedef struct
+{
+    const void *active;   /* first cell of the region in the frame being drawn */
+    const void *previous; /* same cell in the buffer that mirrors the terminal */
+    size_t stride;        /* cells between rows */
+    size_t width;
+    size_t height;
+}
+disp_region_t;
+
+/*
+* Finds the shift that makes most rows of `previous` line up with `active`.
+* Positive shift means content moved up: active row `r` equals previous row `r + shift`.
+* Returns zero when scrolling would not pay off.
+* `hashes` is a scratch of at least 2 * height entries.
+*/
+int disp_detect_shift(const disp_region_t *const region, uint64_t hashes[]);
+
+#endif/*_SCROLL_H_*/
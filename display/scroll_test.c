@@ -0,0 +1,111 @@
+#include "scroll.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/*
+* Content of `previous` is moved by a known shift into `active`,
+* exposed rows get new content, the shift has to be found back.
+*/
+
+#define WIDTH  12
+#define HEIGHT 24
+#define STRIDE 16 /* region is a part of wider rows */
+
+static uint64_t active[HEIGHT][STRIDE];
+static uint64_t previous[HEIGHT][STRIDE];
+static uint64_t hashes[2 * HEIGHT];
+static uint64_t next_cell = 1;
+
+
+static void fill_row(uint64_t row[])
+{
+    for (size_t i = 0; i < STRIDE; ++i) row[i] = next_cell++;
+}
+
+
+static int detect(const size_t height)
+{
+    const disp_region_t region = {
+        .active = &active[0][0],
+        .previous = &previous[0][0],
+        .stride = STRIDE,
+        .width = WIDTH,
+        .height = height,
+    };
+    return disp_detect_shift(&region, hashes);
+}
+
+
+/* active row `r` shows previous row `r + shift` */
+static void make_shifted(const size_t height, const int shift)
+{
+    for (size_t r = 0; r < height; ++r)
+    {
+        fill_row(previous[r]);
+    }
+    for (size_t r = 0; r < height; ++r)
+    {
+        const long from = (long)r + shift;
+        if (from >= 0 && from < (long)height)
+        {
+            for (size_t i = 0; i < STRIDE; ++i) active[r][i] = previous[from][i];
+        }
+        else
+        {
+            fill_row(active[r]);
+        }
+    }
+}
+
+
+static void check_shifts(const size_t height)
+{
+    const int max_shift = height / 2;
+    for (int shift = -max_shift; shift <= max_shift; ++shift)
+    {
+        make_shifted(height, shift);
+        const int found = detect(height);
+
+        /* half of the rows or more have to line up to pay off */
+        const size_t kept = height - abs(shift);
+        const bool pays_off = kept >= SCROLL_MIN_ROWS && kept * 2 >= height;
+        assert(found == (pays_off ? shift : 0));
+    }
+}
+
+
+int main(void)
+{
+    for (size_t height = 0; height <= HEIGHT; ++height)
+    {
+        check_shifts(height);
+    }
+
+    /* nothing moved */
+    make_shifted(HEIGHT, 0);
+    assert(0 == detect(HEIGHT));
+
+    /* everything changed */
+    for (size_t r = 0; r < HEIGHT; ++r)
+    {
+        fill_row(previous[r]);
+        fill_row(active[r]);
+    }
+    assert(0 == detect(HEIGHT));
+
+    /* a changed cell breaks the match of its row only */
+    make_shifted(HEIGHT, 3);
+    active[5][WIDTH - 1] = 0;
+    assert(3 == detect(HEIGHT));
+
+    /* columns out of the region don't matter */
+    make_shifted(HEIGHT, -2);
+    for (size_t r = 0; r < HEIGHT; ++r) active[r][WIDTH] = 0;
+    assert(-2 == detect(HEIGHT));
+
+    puts("scroll: ok");
+    return EXIT_SUCCESS;
+}
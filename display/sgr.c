@@ -0,0 +1,262 @@
+#include "sgr.h"
+
+#include <string.h>
+
+#define SGR_PARAMS_MAX 16
+#define SGR_SCRATCH_SIZE (2 * SGR_SEQ_MAX_SIZE)
+
+/* Accumulates parameters of a single "ESC[...m" sequence */
+typedef struct
+{
+    char   buf[SGR_SCRATCH_SIZE];
+    size_t size;
+}
+sgr_writer_t;
+
+static void parse_params(sgr_state_t *const state, const unsigned int params[], const size_t count);
+static const char *parse_csi(const char *seq, unsigned int params[static SGR_PARAMS_MAX], size_t *count, char *final);
+static sgr_color_t extended_color(const unsigned int params[], const size_t count, size_t *const at);
+static sgr_color_t indexed_color(const unsigned int index);
+
+static void put_param(sgr_writer_t *const w, const unsigned int value);
+static void put_attrs(sgr_writer_t *const w, const uint16_t attrs);
+static void put_color(sgr_writer_t *const w, const sgr_color_t color, const unsigned int base);
+static size_t finish(sgr_writer_t *const w, char *const out);
+
+static bool color_equal(const sgr_color_t a, const sgr_color_t b);
+
+
+void sgr_parse(sgr_state_t *const state, const char *seq)
+{
+    unsigned int params[SGR_PARAMS_MAX];
+    size_t count;
+    char final;
+
+    while (seq && *seq)
+    {
+        seq = parse_csi(seq, params, &count, &final);
+        if ('m' == final)
+        {
+            parse_params(state, params, count);
+        }
+    }
+}
+
+
+bool sgr_equal(const sgr_state_t *const a, const sgr_state_t *const b)
+{
+    return a->attrs == b->attrs
+        && color_equal(a->fg, b->fg)
+        && color_equal(a->bg, b->bg);
+}
+
+
+size_t sgr_transition(const sgr_state_t *const from, const sgr_state_t *const to,
+        char out[static SGR_SEQ_MAX_SIZE])
+{
+    if (sgr_equal(from, to)) return 0;
+
+    /* incremental: switch off removed attributes, then switch on added ones */
+    sgr_writer_t inc = {0};
+    uint16_t removed = from->attrs & ~to->attrs;
+    uint16_t added = to->attrs & ~from->attrs;
+
+    if (removed & (SGR_ATTR_BOLD | SGR_ATTR_DIM))
+    {
+        put_param(&inc, 22); /* disables both */
+        added |= to->attrs & (SGR_ATTR_BOLD | SGR_ATTR_DIM);
+    }
+    if (removed & SGR_ATTR_ITALIC)    put_param(&inc, 23);
+    if (removed & SGR_ATTR_UNDERLINE) put_param(&inc, 24);
+    if (removed & (SGR_ATTR_BLINK | SGR_ATTR_RAPID))
+    {
+        put_param(&inc, 25); /* disables both */
+        added |= to->attrs & (SGR_ATTR_BLINK | SGR_ATTR_RAPID);
+    }
+    if (removed & SGR_ATTR_REVERSE)   put_param(&inc, 27);
+    if (removed & SGR_ATTR_HIDDEN)    put_param(&inc, 28);
+    if (removed & SGR_ATTR_STRIKE)    put_param(&inc, 29);
+
+    put_attrs(&inc, added);
+    if (!color_equal(from->fg, to->fg)) put_color(&inc, to->fg, 30);
+    if (!color_equal(from->bg, to->bg)) put_color(&inc, to->bg, 40);
+
+    /* reset: drop everything and build the state from scratch */
+    sgr_writer_t rst = {0};
+    put_param(&rst, 0);
+    put_attrs(&rst, to->attrs);
+    if (SGR_COLOR_DEFAULT != to->fg.type) put_color(&rst, to->fg, 30);
+    if (SGR_COLOR_DEFAULT != to->bg.type) put_color(&rst, to->bg, 40);
+
+    return (inc.size < rst.size)
+        ? finish(&inc, out)
+        : finish(&rst, out);
+}
+
+
+/*
+* Scans for the next CSI sequence and collects its numeric parameters.
+* Returns pointer past the sequence.
+*/
+static const char *parse_csi(const char *seq, unsigned int params[static SGR_PARAMS_MAX], size_t *count, char *final)
+{
+    *count = 0;
+    *final = '\0';
+
+    seq = strstr(seq, "\x1b[");
+    if (!seq) return NULL;
+    seq += 2;
+
+    unsigned int value = 0;
+    for (; *seq; ++seq)
+    {
+        if ('0' <= *seq && *seq <= '9')
+        {
+            value = value * 10 + (*seq - '0');
+        }
+        else if (';' == *seq || ':' == *seq)
+        {
+            if (*count < SGR_PARAMS_MAX) params[(*count)++] = value;
+            value = 0;
+        }
+        else
+        {
+            if (*count < SGR_PARAMS_MAX) params[(*count)++] = value;
+            *final = *seq++;
+            break;
+        }
+    }
+    return seq;
+}
+
+
+static void parse_params(sgr_state_t *const state, const unsigned int params[], const size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        const unsigned int p = params[i];
+        switch (p)
+        {
+            case 0:  *state = SGR_DEFAULT_STATE; break;
+            case 1: case 2: case 3: case 4: case 5:
+            case 6: case 7: case 8: case 9:
+                     state->attrs |= 1 << (p - 1); break;
+            case 21: state->attrs |= SGR_ATTR_UNDERLINE; break;
+            case 22: state->attrs &= ~(SGR_ATTR_BOLD | SGR_ATTR_DIM); break;
+            case 23: state->attrs &= ~SGR_ATTR_ITALIC; break;
+            case 24: state->attrs &= ~SGR_ATTR_UNDERLINE; break;
+            case 25: state->attrs &= ~(SGR_ATTR_BLINK | SGR_ATTR_RAPID); break;
+            case 27: state->attrs &= ~SGR_ATTR_REVERSE; break;
+            case 28: state->attrs &= ~SGR_ATTR_HIDDEN; break;
+            case 29: state->attrs &= ~SGR_ATTR_STRIKE; break;
+            case 38: state->fg = extended_color(params, count, &i); break;
+            case 39: state->fg = (sgr_color_t){0}; break;
+            case 48: state->bg = extended_color(params, count, &i); break;
+            case 49: state->bg = (sgr_color_t){0}; break;
+            default:
+                if (30 <= p && p <= 37)        state->fg = indexed_color(p - 30);
+                else if (40 <= p && p <= 47)   state->bg = indexed_color(p - 40);
+                else if (90 <= p && p <= 97)   state->fg = indexed_color(p - 90 + 8);
+                else if (100 <= p && p <= 107) state->bg = indexed_color(p - 100 + 8);
+                /* the rest is not modeled */
+        }
+    }
+}
+
+
+/* 38;5;n or 38;2;r;g;b, `at` points to 38/48 and is advanced past the color */
+static sgr_color_t extended_color(const unsigned int params[], const size_t count, size_t *const at)
+{
+    size_t i = *at;
+    if (i + 2 < count && 5 == params[i + 1])
+    {
+        *at = i + 2;
+        return indexed_color(params[i + 2]);
+    }
+    if (i + 4 < count && 2 == params[i + 1])
+    {
+        *at = i + 4;
+        return (sgr_color_t){
+            .type = SGR_COLOR_RGB,
+            .r = params[i + 2],
+            .g = params[i + 3],
+            .b = params[i + 4],
+        };
+    }
+    *at = count; /* malformed, skip the rest */
+    return (sgr_color_t){0};
+}
+
+
+static sgr_color_t indexed_color(const unsigned int index)
+{
+    return (sgr_color_t){ .type = SGR_COLOR_INDEXED, .r = index };
+}
+
+
+static void put_param(sgr_writer_t *const w, const unsigned int value)
+{
+    char digits[3];
+    size_t n = 0;
+    unsigned int v = value;
+    do { digits[n++] = '0' + v % 10; v /= 10; } while (v && n < sizeof(digits));
+
+    if (w->size) w->buf[w->size++] = ';';
+    while (n) w->buf[w->size++] = digits[--n];
+}
+
+
+static void put_attrs(sgr_writer_t *const w, const uint16_t attrs)
+{
+    for (unsigned int bit = 0; bit < 9; ++bit)
+    {
+        if (attrs & (1 << bit)) put_param(w, bit + 1);
+    }
+}
+
+
+/* `base` is 30 for foreground and 40 for background */
+static void put_color(sgr_writer_t *const w, const sgr_color_t color, const unsigned int base)
+{
+    switch (color.type)
+    {
+        case SGR_COLOR_DEFAULT:
+            put_param(w, base + 9);
+            break;
+        case SGR_COLOR_INDEXED:
+            if (color.r < 8)       put_param(w, base + color.r);
+            else if (color.r < 16) put_param(w, base + 60 + color.r - 8);
+            else
+            {
+                put_param(w, base + 8);
+                put_param(w, 5);
+                put_param(w, color.r);
+            }
+            break;
+        case SGR_COLOR_RGB:
+            put_param(w, base + 8);
+            put_param(w, 2);
+            put_param(w, color.r);
+            put_param(w, color.g);
+            put_param(w, color.b);
+            break;
+    }
+}
+
+
+static size_t finish(sgr_writer_t *const w, char *const out)
+{
+    out[0] = '\x1b';
+    out[1] = '[';
+    memcpy(out + 2, w->buf, w->size);
+    out[2 + w->size] = 'm';
+    return w->size + 3;
+}
+
+
+static bool color_equal(const sgr_color_t a, const sgr_color_t b)
+{
+    return a.type == b.type
+        && (SGR_COLOR_DEFAULT == a.type
+            || (a.r == b.r && a.g == b.g && a.b == b.b));
+}
@@ -0,0 +1,73 @@
+#ifndef _SGR_H_
+#define _SGR_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+* Model of the terminal graphic rendition (SGR) state.
+* Styles are parsed into it once, so that presenter can emit
+* only a difference between two consecutive states.
+*/
+
+#define SGR_SEQ_MAX_SIZE 64 /* enough for a full state with two rgb colors */
+
+typedef enum
+{
+    SGR_ATTR_BOLD      = 1 << 0, /* 1 */
+    SGR_ATTR_DIM       = 1 << 1, /* 2 */
+    SGR_ATTR_ITALIC    = 1 << 2, /* 3 */
+    SGR_ATTR_UNDERLINE = 1 << 3, /* 4 */
+    SGR_ATTR_BLINK     = 1 << 4, /* 5 */
+    SGR_ATTR_RAPID     = 1 << 5, /* 6 */
+    SGR_ATTR_REVERSE   = 1 << 6, /* 7 */
+    SGR_ATTR_HIDDEN    = 1 << 7, /* 8 */
+    SGR_ATTR_STRIKE    = 1 << 8, /* 9 */
+}
+sgr_attr_t;
+
+typedef enum
+{
+    SGR_COLOR_DEFAULT = 0,
+    SGR_COLOR_INDEXED, /* 0-15 basic and bright, 16-255 extended palette */
+    SGR_COLOR_RGB,
+}
+sgr_color_type_t;
+
+typedef struct
+{
+    uint8_t type; /* stores a value of sgr_color_type_t */
+    uint8_t r;    /* palette index for SGR_COLOR_INDEXED */
+    uint8_t g;
+    uint8_t b;
+}
+sgr_color_t;
+
+typedef struct
+{
+    uint16_t    attrs; /* set of sgr_attr_t */
+    sgr_color_t fg;
+    sgr_color_t bg;
+}
+sgr_state_t;
+
+#define SGR_DEFAULT_STATE ((sgr_state_t){0})
+
+/*
+* Applies all SGR sequences found in `seq` on top of the `state`.
+* Parameters that are not modeled are ignored.
+*/
+void sgr_parse(sgr_state_t *const state, const char *seq);
+
+bool sgr_equal(const sgr_state_t *const a, const sgr_state_t *const b);
+
+/*
+* Writes the shortest sequence that turns terminal from `from` state to `to`.
+* Returns amount of bytes written, zero when states are equal.
+* `out` must be able to hold at least SGR_SEQ_MAX_SIZE bytes.
+*/
+size_t sgr_transition(const sgr_state_t *const from, const sgr_state_t *const to,
+        char out[static SGR_SEQ_MAX_SIZE]);
+
+#endif/*_SGR_H_*/
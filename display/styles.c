@@ -0,0 +1,156 @@
+#include "styles.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define STYLES_INITIAL_CAP 16
+
+static uint32_t hash_seq(const char *seq);
+static size_t find_slot(const disp_styles_t *const styles, const char *const seq);
+static void grow_entries(disp_styles_t *const styles);
+static void grow_index(disp_styles_t *const styles);
+static void *alloc_or_die(void *ptr, const size_t size);
+
+
+void disp_styles_init(disp_styles_t *const styles)
+{
+    *styles = (disp_styles_t){
+        .entries = alloc_or_die(NULL, STYLES_INITIAL_CAP * sizeof(disp_style_entry_t)),
+        .capacity = STYLES_INITIAL_CAP,
+        .index = alloc_or_die(NULL, 2 * STYLES_INITIAL_CAP * sizeof(disp_style_id_t)),
+        .index_cap = 2 * STYLES_INITIAL_CAP,
+    };
+    memset(styles->index, 0, styles->index_cap * sizeof(disp_style_id_t));
+
+    /* id zero is reserved for the default style */
+    styles->entries[DISP_STYLE_DEFAULT] = (disp_style_entry_t){
+        .seq = NULL,
+        .sgr = SGR_DEFAULT_STATE,
+    };
+    styles->count = 1;
+}
+
+
+void disp_styles_deinit(disp_styles_t *const styles)
+{
+    for (size_t id = 0; id < styles->count; ++id)
+    {
+        free(styles->entries[id].seq);
+    }
+    free(styles->entries);
+    free(styles->index);
+    *styles = (disp_styles_t){0};
+}
+
+
+disp_style_id_t disp_styles_intern(disp_styles_t *const styles, const char *const seq)
+{
+    if (!seq || !*seq) return DISP_STYLE_DEFAULT;
+
+    /* content is compared too, caller may reuse the same buffer for another style */
+    if (seq == styles->last_seq
+        && 0 == strcmp(seq, styles->entries[styles->last_id].seq))
+    {
+        return styles->last_id;
+    }
+
+    size_t slot = find_slot(styles, seq);
+    disp_style_id_t id = styles->index[slot];
+
+    if (DISP_STYLE_DEFAULT == id)
+    {
+        if (styles->count > DISP_STYLES_MAX) return DISP_STYLE_DEFAULT;
+
+        if (styles->count == styles->capacity) grow_entries(styles);
+
+        id = styles->count++;
+        disp_style_entry_t *entry = &styles->entries[id];
+        *entry = (disp_style_entry_t){
+            .seq = alloc_or_die(NULL, strlen(seq) + 1),
+            .sgr = SGR_DEFAULT_STATE,
+        };
+        strcpy(entry->seq, seq);
+        sgr_parse(&entry->sgr, seq);
+
+        styles->index[slot] = id;
+
+        /* keep load factor under one half */
+        if (2 * styles->count > styles->index_cap) grow_index(styles);
+    }
+
+    styles->last_seq = seq;
+    styles->last_id = id;
+    return id;
+}
+
+
+const sgr_state_t *disp_styles_sgr(const disp_styles_t *const styles, const disp_style_id_t id)
+{
+    return &styles->entries[id < styles->count ? id : DISP_STYLE_DEFAULT].sgr;
+}
+
+
+/* FNV-1a */
+static uint32_t hash_seq(const char *seq)
+{
+    uint32_t hash = 2166136261u;
+    for (; *seq; ++seq)
+    {
+        hash ^= (unsigned char)*seq;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+
+/* Returns slot that holds `seq` or a free slot where it belongs */
+static size_t find_slot(const disp_styles_t *const styles, const char *const seq)
+{
+    const size_t mask = styles->index_cap - 1;
+    size_t slot = hash_seq(seq) & mask;
+
+    for (;;)
+    {
+        const disp_style_id_t id = styles->index[slot];
+        if (DISP_STYLE_DEFAULT == id || 0 == strcmp(styles->entries[id].seq, seq))
+        {
+            return slot;
+        }
+        slot = (slot + 1) & mask;
+    }
+}
+
+
+static void grow_entries(disp_styles_t *const styles)
+{
+    styles->capacity *= 2;
+    styles->entries = alloc_or_die(styles->entries,
+            styles->capacity * sizeof(disp_style_entry_t));
+}
+
+
+static void grow_index(disp_styles_t *const styles)
+{
+    free(styles->index);
+    styles->index_cap *= 2;
+    styles->index = alloc_or_die(NULL, styles->index_cap * sizeof(disp_style_id_t));
+    memset(styles->index, 0, styles->index_cap * sizeof(disp_style_id_t));
+
+    for (size_t id = 1; id < styles->count; ++id)
+    {
+        styles->index[find_slot(styles, styles->entries[id].seq)] = id;
+    }
+}
+
+
+static void *alloc_or_die(void *ptr, const size_t size)
+{
+    void *mem = realloc(ptr, size);
+    if (!mem)
+    {
+        perror("disp_styles");
+        exit(EXIT_FAILURE);
+    }
+    return mem;
+}
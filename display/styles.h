@@ -0,0 +1,47 @@
+#ifndef _STYLES_H_
+#define _STYLES_H_
+
+#include "sgr.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+* Registry that interns style sequences into small integer ids.
+* Sequences with equal content share the same id regardless of their address,
+* each one is copied and parsed into the SGR model only once.
+*/
+
+typedef uint16_t disp_style_id_t;
+
+#define DISP_STYLE_DEFAULT ((disp_style_id_t) 0) /* no style at all */
+#define DISP_STYLES_MAX UINT16_MAX
+
+typedef struct
+{
+    char        *seq; /* own copy of the sequence */
+    sgr_state_t sgr;
+}
+disp_style_entry_t;
+
+typedef struct
+{
+    disp_style_entry_t *entries;  /* indexed by id */
+    size_t             count;
+    size_t             capacity;
+    disp_style_id_t    *index;    /* open addressing table of ids, zero marks a free slot */
+    size_t             index_cap; /* power of two */
+    const char         *last_seq; /* most styles are set for many cells in a row */
+    disp_style_id_t    last_id;
+}
+disp_styles_t;
+
+void disp_styles_init(disp_styles_t *const styles);
+void disp_styles_deinit(disp_styles_t *const styles);
+
+/* Returns DISP_STYLE_DEFAULT for NULL or empty sequence, or when registry is full */
+disp_style_id_t disp_styles_intern(disp_styles_t *const styles, const char *const seq);
+
+const sgr_state_t *disp_styles_sgr(const disp_styles_t *const styles, const disp_style_id_t id);
+
+#endif/*_STYLES_H_*/
@@ -0,0 +1,171 @@
+#include "input.h"
+
+#include <assert.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/*
+* A burst is fed through a pipe standing in for stdin and read in one batch,
+* hooks record what survived coalescing in the order it was delivered.
+*/
+
+#define MAX_EVENTS 32
+
+typedef struct
+{
+    char kind;
+    unsigned int x;
+    keycode_t code;
+    input_modifier_t modifier;
+    unsigned int repeat;
+}
+recorded_t;
+
+typedef struct
+{
+    recorded_t events[MAX_EVENTS];
+    size_t count;
+}
+record_t;
+
+
+static void record(record_t *const rec, const recorded_t event)
+{
+    assert(rec->count < MAX_EVENTS);
+    rec->events[rec->count++] = event;
+}
+
+static void on_hover(const mouse_event_t *const e, void *const param)
+{
+    record(param, (recorded_t){ .kind = 'h', .x = e->position.x });
+}
+
+static void on_press(const mouse_event_t *const e, void *const param)
+{
+    record(param, (recorded_t){ .kind = 'p', .x = e->position.x });
+}
+
+static void on_drag_begin(const mouse_event_t *const e, void *const param)
+{
+    record(param, (recorded_t){ .kind = 'b', .x = e->position.x });
+}
+
+static void on_drag(const mouse_event_t *const begin, const mouse_event_t *const e, void *const param)
+{
+    (void)begin;
+    record(param, (recorded_t){ .kind = 'd', .x = e->position.x });
+}
+
+static void on_drag_end(const mouse_event_t *const begin, const mouse_event_t *const e, void *const param)
+{
+    (void)begin; (void)e;
+    record(param, (recorded_t){ .kind = 'e' });
+}
+
+static void on_keystroke(const keystroke_event_t *const e, void *const param)
+{
+    record(param, (recorded_t){
+        .kind = 'k', .code = e->code, .modifier = e->modifier, .repeat = e->repeat
+    });
+}
+
+
+/* input_init and input_deinit talk to the terminal, keep it out of the test output */
+static int silence_stdout(void)
+{
+    fflush(stdout);
+    const int saved = dup(STDOUT_FILENO);
+    const int null = open("/dev/null", O_WRONLY);
+    if (-1 == saved || -1 == null)
+    {
+        perror("open");
+        exit(EXIT_FAILURE);
+    }
+    dup2(null, STDOUT_FILENO);
+    close(null);
+    return saved;
+}
+
+static void restore_stdout(const int saved)
+{
+    fflush(stdout);
+    dup2(saved, STDOUT_FILENO);
+    close(saved);
+}
+
+
+static void expect(const recorded_t *const got, const recorded_t want)
+{
+    assert(got->kind == want.kind);
+    assert(got->x == want.x);
+    assert(got->code == want.code);
+    assert(got->modifier == want.modifier);
+    assert(got->repeat == want.repeat);
+}
+
+
+int main(void)
+{
+    int fds[2];
+    if (-1 == pipe(fds) || -1 == dup2(fds[0], STDIN_FILENO))
+    {
+        perror("pipe");
+        exit(EXIT_FAILURE);
+    }
+
+    const char burst[] =
+        /* hovers, a key in between does not break the run */
+        "\x1b[<35;1;1M" "\x1b[<35;2;1M" "x" "\x1b[<35;3;1M"
+        /* press, drags, release */
+        "\x1b[<0;3;1M" "\x1b[<32;4;1M" "\x1b[<32;5;1M" "\x1b[<32;6;1M" "\x1b[<0;6;1m"
+        /* arrows are summed, any other key or a modifier change splits them */
+        "\x1b[B" "\x1b[B" "\x1b[B" "a" "\x1b[B" "\x1b[1;5B" "\x1b[1;5B";
+
+    const ssize_t written = write(fds[1], burst, sizeof burst - 1);
+    assert(written == (ssize_t)sizeof burst - 1);
+
+    int saved = silence_stdout();
+    input_t input = input_init();
+    restore_stdout(saved);
+    const input_hooks_t hooks = {
+        .on_hover = on_hover,
+        .on_press = on_press,
+        .on_drag_begin = on_drag_begin,
+        .on_drag = on_drag,
+        .on_drag_end = on_drag_end,
+        .on_keystroke = on_keystroke,
+    };
+
+    record_t rec = { .count = 0 };
+    input_wait_events(&input, &hooks, &rec, 100);
+    saved = silence_stdout();
+    input_deinit(&input);
+    restore_stdout(saved);
+
+    const recorded_t want[] = {
+        { .kind = 'k', .code = KEY_X, .repeat = 1 },
+        { .kind = 'h', .x = 2 },
+        { .kind = 'p', .x = 2 },
+        { .kind = 'b', .x = 2 },
+        { .kind = 'd', .x = 5 },
+        { .kind = 'e' },
+        { .kind = 'k', .code = KEY_DOWN, .repeat = 3 },
+        { .kind = 'k', .code = KEY_A, .repeat = 1 },
+        { .kind = 'k', .code = KEY_DOWN, .repeat = 1 },
+        { .kind = 'k', .code = KEY_DOWN, .modifier = MOD_CTRL, .repeat = 2 },
+    };
+
+    assert(rec.count == sizeof want / sizeof *want);
+    for (size_t i = 0; i < rec.count; ++i)
+    {
+        expect(&rec.events[i], want[i]);
+    }
+
+    close(fds[0]);
+    close(fds[1]);
+    puts("coalesce: ok");
+    return EXIT_SUCCESS;
+}
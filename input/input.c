@@ -1,7 +1,6 @@
 #include "input.h"
 #include "display.h"
 #include "hash.h"
-#include "circbuf.h"
 #include "logger.h"
 
 #include <stdio.h>
@@ -11,31 +10,70 @@
 #include <stdlib.h>
 #include <errno.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <sys/wait.h>
 #include <sys/epoll.h>
+#include <poll.h>
 #include <assert.h>
 #include <fcntl.h>
 #include <ctype.h>
+#include <limits.h>
 
 #define MAX_EVENTS 10
-#define FEED_ERROR(ch) { S_LOG(LOGGER_CRITICAL, "Error: '%c' = (%x)\n", ch, ch); return INPUT_ERROR; }
+#define PASTE_BEGIN 200 /* ESC [ 200 ~ */
+#define PARAM_VALUE_LIMIT 100000 /* larger than any sane parameter, stops overflow */
 
 
-typedef struct
+/* Watched fd, allocated separately, so it stays put while the map grows */
+typedef struct descriptor
 {
-    int temp;
+    int fd;
+    int flags; /* original, restored when unwatched */
+    ring_t queue;
+    input_fd_callback_t callback;
+    void *data;
+    struct descriptor *next;
 }
-buffer_t;
+descriptor_t;
 
+static keystroke_event_t g_ascii_events[128]; /* filled by input_init */
 
-static void handle_mouse(input_t *const input, const input_hooks_t *const hooks, void *const param);
+
+static void handle_mouse(input_t *const input, const input_hooks_t *const hooks, void *const param,
+        const mouse_event_t event);
 static void handle_keyboard(input_t *const input, const input_hooks_t *const hooks, void *const param);
-static mouse_event_t decode_mouse_event(unsigned char buffer[static 3]);
+static mouse_event_t decode_mouse_event(const unsigned int code, const unsigned int col, const unsigned int row);
 static void print_mouse_event(const mouse_event_t *const event);
-static int input_read(input_t *const input);
+static int input_read(input_t *const input, const bool readable);
+static int read_queue(const int fd, ring_t *const queue, const bool blocking, bool readable);
+static bool is_readable(const int fd);
+static void service_fd(input_t *const input, const int fd, const uint32_t events);
+static void destroy_descriptor(descriptor_t *const desc);
 static void input_on_timeout(input_t *const input, const input_hooks_t *const hooks, void *const param);
+static int input_dispatch(input_t *const input, const input_hooks_t *const hooks, void *const param,
+        const struct epoll_event events[], const int events_num);
+static void escape_expired(void *const data);
+static void push_event(input_t *const input, const input_hooks_t *const hooks, void *const param,
+        const input_event_t event);
+static void push_mouse(input_t *const input, const input_hooks_t *const hooks, void *const param,
+        const input_event_type_t type, const mouse_event_t *const begin, const mouse_event_t *const mouse);
+static void flush_batch(input_t *const input, const input_hooks_t *const hooks, void *const param);
+static void coalesce_batch(input_event_t batch[], const size_t size);
+static void dispatch_event(const input_t *const input, const input_event_t *const event,
+        const input_hooks_t *const hooks, void *const param);
+static void paste_append(paste_buffer_t *const paste, const void *const data, const size_t size);
+static void paste_end(input_t *const input, const input_hooks_t *const hooks, void *const param);
+static bool is_repeatable(const keystroke_event_t *const a, const keystroke_event_t *const b);
 static int input_process(input_t *const input, const input_hooks_t *const hooks, void *const param);
-static int input_feed(input_t *const input, const input_hooks_t *const hooks, void *const param, const char ch);
+static int input_scan(input_t *const input, const input_hooks_t *const hooks, void *const param,
+        const unsigned char *const data, const size_t size);
+static void input_act(input_t *const input, const input_hooks_t *const hooks, void *const param,
+        const parser_action_t action, const parser_state_t from, const unsigned char ch);
+static void csi_dispatch(input_t *const input, const input_hooks_t *const hooks, void *const param,
+        const unsigned char final);
+static void ss3_dispatch(input_t *const input, const input_hooks_t *const hooks, void *const param,
+        const unsigned char final);
+static void arm_escape(input_t *const input);
 
 static bool is_upper(int ch);
 static bool is_control_char(int ch);
@@ -47,6 +85,10 @@ static keystroke_event_t make_fk_event(int ch, input_modifier_t mod);
 static keycode_t map_ascii(int ch);
 static keycode_t map_nav(int ch);
 static keycode_t map_fk(int ch);
+static bool map_tilde(unsigned int number, keycode_t *const code);
+static bool make_csi_u_event(const unsigned int code, const input_modifier_t mod, keystroke_event_t *const ke);
+static void keyboard_reply(input_t *const input, const unsigned char final);
+static void mode_reply(input_t *const input, const unsigned int mode, const unsigned int value);
 
 
 input_t input_init(void)
@@ -69,31 +111,47 @@ input_t input_init(void)
     hashmap_t *descriptors = hm_create(
         .hashfunc = hash_int,
         .key_size = sizeof(int),
-        .value_size = sizeof(buffer_t),
+        .value_size = sizeof(descriptor_t*),
     );
     if (!descriptors)
     {
         exit(EXIT_FAILURE);
     }
-    circbuf_t *queue = circbuf_create(.initial_cap=INPUT_QUEUE_SIZE);
-    if (!queue)
+
+    for (int ch = 0; ch < 128; ++ch)
     {
-        exit(EXIT_FAILURE);
+        g_ascii_events[ch] = make_ascii_event(ch);
     }
 
-
-    return (input_t) {
-        .queue = queue,
+    input_t input = {
         .epfd = epfd,
         .descriptors = descriptors,
     };
+    ring_init(&input.queue, INPUT_QUEUE_SIZE);
+    timers_init(&input.timers, epfd);
+
+    /* legacy parsing goes on until terminal tells it knows better */
+    printf(MARGINS_QUERY KEYBOARD_QUERY);
+    fflush(stdout);
+    return input;
 }
 
 
 void input_deinit(input_t *const input)
 {
+    if (KEYBOARD_KITTY == input->keyboard)
+    {
+        printf(KEYBOARD_POP);
+        fflush(stdout);
+    }
+    timers_deinit(&input->timers);
+    free(input->paste.data);
+    while (input->watched)
+    {
+        input_unwatch_fd(input, input->watched->fd);
+    }
     hm_destroy(input->descriptors);
-    circbuf_destroy(input->queue);
+    ring_deinit(&input->queue);
     close(input->epfd);
 }
 
@@ -107,7 +165,7 @@ void input_enable_mouse(void)
     attr.c_cc[VTIME] = 0; // No timeout
     attr.c_lflag &= ~(ICANON | ECHO | ISIG);
     tcsetattr(STDIN_FILENO, TCSANOW, &attr);
-    printf(MOUSE_EVENTS_ON PASTE_MODE_ON);
+    printf(MOUSE_EVENTS_ON MOUSE_SGR_ON PASTE_MODE_ON);
     fflush(stdout);
 }
 
@@ -119,494 +177,651 @@ void input_disable_mouse(void)
     tcgetattr(STDIN_FILENO, &attr);
     attr.c_lflag |= (ICANON | ECHO | ISIG);
     tcsetattr(STDIN_FILENO, TCSANOW, &attr);
-    printf(MOUSE_EVENTS_OFF PASTE_MODE_OFF);
+    printf(MOUSE_EVENTS_OFF MOUSE_SGR_OFF PASTE_MODE_OFF);
     fflush(stdout);
 }
 
 
 int input_handle_events(input_t *const input, const input_hooks_t *const hooks, void *const param)
 {
-    struct epoll_event events[MAX_EVENTS];
-    int events_num = 0;
-    // acquire events
-    while (true)
+    return input_wait_events(input, hooks, param, INPUT_ESC_TIMEOUT);
+}
+
+
+/*
+* Waits up to `timeout` ms (-1 blocks) for input or a due timer,
+* then keeps dispatching while more of it is ready,
+* so that a caller renders once per burst.
+* Returns early on a signal, letting the caller look at what it changed.
+*/
+int input_wait_events(input_t *const input, const input_hooks_t *const hooks, void *const param, int timeout)
+{
+    input->hooks = hooks;
+    input->param = param;
+
+    int status = INPUT_SUCCESS;
+    for (int round = 0; round < INPUT_DRAIN_ROUNDS && INPUT_SUCCESS == status; ++round)
     {
-        events_num = epoll_wait(input->epfd, events, MAX_EVENTS, 10);
-        if (events_num != -1)
-        {
-            break; // epoll succeded
-        }
-        else if (errno != EINTR) // something went wrong
+        struct epoll_event events[MAX_EVENTS];
+        const int events_num = epoll_wait(input->epfd, events, MAX_EVENTS, round ? 0 : timeout);
+        if (-1 == events_num)
         {
+            if (EINTR == errno) break;
             perror("epoll_wait");
             return errno;
         }
-        // Retry epoll_wait
+
+        if (!events_num) break;
+
+        status = input_dispatch(input, hooks, param, events, events_num);
     }
 
-    if (!events_num)  input_on_timeout(input, hooks, param);
+    flush_batch(input, hooks, param);
+    return status;
+}
+
 
-    for (int e = 0; e < events_num; e++)
+void input_display_overlay(input_t *const input, disp_pos_t pos)
+{
+    printf(ESC "[%d;%dH", pos.y, pos.x);
+    print_mouse_event(&input->mouse_mode.last_mouse_event);
+}
+
+
+int input_watch_fd(input_t *const input, const int fd, const size_t queue_size,
+        input_fd_callback_t callback, void *const data)
+{
+    assert(callback);
+    if (hm_get(input->descriptors, &fd))
     {
-        if (events[e].events & EPOLLIN)
-        {
-            // process standard input
-            if (events[e].data.fd == STDIN_FILENO)
-            {
-                // Data available from stdin
-                int status = input_read(input);
-                if (0 != status)
-                {
-                    return status;
-                }
+        return INPUT_ERROR; /* already watched */
+    }
 
-                // Try to process the data
-                status = input_process(input, hooks, param);
-                if (0 != status)
-                {
-                    return status;
-                }
-            }
+    const int flags = fcntl(fd, F_GETFL);
+    if (-1 == flags || -1 == fcntl(fd, F_SETFL, flags | O_NONBLOCK))
+    {
+        perror("fcntl: watched fd");
+        return INPUT_ERROR;
+    }
 
-            { // process buffers
-                buffer_t *buffer = hm_get(input->descriptors, &events[e].data.fd);
-                if (buffer)
-                {
-                    // write data to buffer
-                }
-            }
+    struct epoll_event ev = {
+        .events = EPOLLIN,
+        .data.fd = fd,
+    };
+    if (-1 == epoll_ctl(input->epfd, EPOLL_CTL_ADD, fd, &ev))
+    {
+        perror("epoll_ctl: watched fd");
+        fcntl(fd, F_SETFL, flags);
+        return INPUT_ERROR;
+    }
+
+    descriptor_t *desc = malloc(sizeof(descriptor_t));
+    if (!desc)
+    {
+        perror("input_watch_fd");
+        exit(EXIT_FAILURE);
+    }
+    *desc = (descriptor_t){
+        .fd = fd,
+        .flags = flags,
+        .callback = callback,
+        .data = data,
+        .next = input->watched,
+    };
+    ring_init(&desc->queue, queue_size ? queue_size : INPUT_FD_QUEUE_SIZE);
+
+    if (hm_insert(&input->descriptors, &fd, &desc))
+    {
+        S_LOG(LOGGER_CRITICAL, "Failed to register descriptor %d\n", fd);
+        exit(EXIT_FAILURE);
+    }
+    input->watched = desc;
+    return INPUT_SUCCESS;
+}
+
+
+void input_unwatch_fd(input_t *const input, const int fd)
+{
+    descriptor_t **const found = hm_get(input->descriptors, &fd);
+    if (!found) return;
+    descriptor_t *const desc = *found;
+
+    for (descriptor_t **link = &input->watched; *link; link = &(*link)->next)
+    {
+        if (*link == desc)
+        {
+            *link = desc->next;
+            break;
         }
     }
-    return 0;
+    hm_remove(input->descriptors, &fd);
+    epoll_ctl(input->epfd, EPOLL_CTL_DEL, fd, NULL);
+    fcntl(fd, F_SETFL, desc->flags);
+    destroy_descriptor(desc);
 }
 
 
-void input_display_overlay(input_t *const input, disp_pos_t pos)
+static int input_read(input_t *input, const bool readable)
 {
-    printf(ESC "[%d;%dH", pos.y, pos.x);
-    print_mouse_event(&input->mouse_mode.last_mouse_event);
+    /* stdin shares its file description with stdout, so it is left blocking */
+    const int status = read_queue(STDIN_FILENO, &input->queue, true, readable);
+    if (INPUT_EXIT == status)
+    {
+        return INPUT_SUCCESS; // nothing to decode
+    }
+    if (INPUT_SUCCESS != status && INPUT_QUEUE_IS_FULL != status)
+    {
+        perror("read from stdin");
+    }
+    return status;
 }
 
 
-static int input_read(input_t *input)
+/*
+* Reads straight into free space of the queue until fd runs dry.
+* A blocking fd is polled before each read instead of waiting for EAGAIN,
+* except the first one when the caller already knows fd is `readable`.
+* Returns INPUT_QUEUE_IS_FULL when the queue has to be processed first,
+* INPUT_EXIT at the end of file, errno on failure.
+*/
+static int read_queue(const int fd, ring_t *const queue, const bool blocking, bool readable)
 {
-    const size_t available_space = circbuf_avail_to_write(input->queue);
-    if (available_space == 0)
+    while (true)
     {
-        return 1;  // queue is full of unprocessed data
+        struct iovec iov[2];
+        const int segments = ring_free_segments(queue, iov);
+        if (!segments)
+        {
+            return INPUT_QUEUE_IS_FULL;
+        }
+        if (blocking && !readable && !is_readable(fd))
+        {
+            return INPUT_SUCCESS;
+        }
+        readable = false;
+
+        const ssize_t input_bytes = readv(fd, iov, segments);
+        if (input_bytes == 0)
+        {
+            return INPUT_EXIT;
+        }
+
+        if (input_bytes == -1)
+        {
+            if (EINTR == errno) continue;
+            if (EAGAIN == errno || EWOULDBLOCK == errno) return INPUT_SUCCESS;
+            return errno; // just propagate error code for now
+        }
+
+        ring_produce(queue, input_bytes);
     }
+}
 
-    const size_t to_read = available_space < INPUT_BUFFER_SIZE
-        ? available_space
-        : INPUT_BUFFER_SIZE;
 
-    unsigned char buffer[INPUT_BUFFER_SIZE] = {0};
-    int input_bytes = read(STDIN_FILENO, buffer, to_read);
+static bool is_readable(const int fd)
+{
+    struct pollfd pfd = { .fd = fd, .events = POLLIN };
+    return poll(&pfd, 1, 0) > 0;
+}
 
-    if (input_bytes == 0)
+
+/*
+* Reads a watched fd and hands the data over, again while the callback
+* makes room in a full queue.
+*/
+static void service_fd(input_t *const input, const int fd, const uint32_t events)
+{
+    bool closed = !(events & EPOLLIN) && (events & (EPOLLHUP | EPOLLERR));
+    while (true)
     {
-        return 0; // nothing to decode
+        descriptor_t **found = hm_get(input->descriptors, &fd);
+        if (!found) return; /* unwatched by a previous callback */
+        descriptor_t *const desc = *found;
+
+        int status = INPUT_SUCCESS;
+        if (!closed)
+        {
+            status = read_queue(fd, &desc->queue, false, true);
+            closed = INPUT_SUCCESS != status && INPUT_QUEUE_IS_FULL != status;
+        }
+
+        const size_t pending = ring_avail_to_read(&desc->queue);
+        desc->callback(input, fd, &desc->queue, closed, desc->data);
+
+        if (closed)
+        {
+            input_unwatch_fd(input, fd);
+            return;
+        }
+
+        /* desc may be gone, the callback could unwatch it */
+        found = hm_get(input->descriptors, &fd);
+        if (INPUT_QUEUE_IS_FULL != status || !found
+            || ring_avail_to_read(&(*found)->queue) == pending)
+        {
+            return;
+        }
     }
+}
+
+
+static void destroy_descriptor(descriptor_t *const desc)
+{
+    ring_deinit(&desc->queue);
+    free(desc);
+}
 
-    if (input_bytes == -1)
+
+static int input_dispatch(input_t *const input, const input_hooks_t *const hooks, void *const param,
+        const struct epoll_event events[], const int events_num)
+{
+    for (int e = 0; e < events_num; e++)
     {
-        int error = errno;
-        perror("read from stdin");
-        return error; // just propagate error code for now
+        if (hm_get(input->descriptors, &events[e].data.fd))
+        {
+            service_fd(input, events[e].data.fd, events[e].events);
+            continue;
+        }
+
+        if (events[e].events & EPOLLIN)
+        {
+            if (events[e].data.fd == input->timers.fd)
+            {
+                timers_expire(&input->timers);
+                continue;
+            }
+
+            // process standard input
+            if (events[e].data.fd == STDIN_FILENO)
+            {
+                // Data available from stdin, a full queue is processed and read again
+                int status;
+                bool readable = true; /* reported by epoll, unknown after a full queue */
+                do
+                {
+                    status = input_read(input, readable);
+                    readable = false;
+                    if (INPUT_SUCCESS != status && INPUT_QUEUE_IS_FULL != status)
+                    {
+                        return status;
+                    }
+                    input_process(input, hooks, param);
+                }
+                while (INPUT_QUEUE_IS_FULL == status);
+            }
+        }
     }
+    return INPUT_SUCCESS;
+}
 
-    // send input into the queue
-    (void) circbuf_write(input->queue, input_bytes, buffer);
-    return 0;
+
+static void escape_expired(void *const data)
+{
+    input_t *const input = data;
+    input->state_machine.escape_timer = 0;
+    input_on_timeout(input, input->hooks, input->param);
 }
 
 
+/*
+* Nothing followed the last chunk in time, so the sequence is not going to complete.
+* ESC, ESC O and ESC [ alone are keys, a partial paste terminator is content,
+* the rest of an unfinished sequence is dropped.
+*/
 static void input_on_timeout(input_t *const input, const input_hooks_t *const hooks, void *const param)
 {
     input_sm_t *sm = &input->state_machine;
-    keystroke_event_t *ke = &input->keystroke_mode.keystroke;
-    if (sm->escape_pressed && '\x1b' == ke->stroke)
+    const parser_state_t from = sm->state;
+    sm->state = PS_GROUND;
+
+    switch (from)
     {
-        sm->state = S0;
-        ke->code = KEY_ESC;
-        ke->modifier = MOD_CTRL;
-        handle_keyboard(input, hooks, param);
+        case PS_GROUND:
+            break;
+
+        case PS_ESCAPE:
+            input_act(input, hooks, param, PA_ESC_KEY, from, '\x1b');
+            break;
+
+        case PS_SS3:
+            input_act(input, hooks, param, PA_ALT_KEY, from, 'O');
+            break;
+
+        case PS_CSI_ENTRY:
+            input_act(input, hooks, param, PA_ALT_KEY, from, '[');
+            break;
+
+        case PS_PASTE:
+            sm->state = PS_PASTE; /* only the terminator ends it */
+            break;
+
+        case PS_PASTE_ESC: case PS_PASTE_CSI: case PS_PASTE_2:
+        case PS_PASTE_20:  case PS_PASTE_201:
+            input_act(input, hooks, param, PA_PASTE_MISMATCH, from, '\x1b');
+            sm->state = PS_PASTE;
+            break;
+
+        default:
+            break;
     }
-    // S_LOG(LOGGER_DEBUG, "TIMEOUT!");
-    input->state_machine.escape_pressed = false;
 }
 
 
+/* Parses queued bytes where they lie */
 static int input_process(input_t *const input, const input_hooks_t *const hooks, void *const param)
 {
-    unsigned char buffer[INPUT_BUFFER_SIZE];
-    const size_t available = circbuf_avail_to_read(input->queue);
-    const size_t to_process = available < INPUT_BUFFER_SIZE
-        ? available
-        : INPUT_BUFFER_SIZE;
+    struct iovec iov[2];
+    const int segments = ring_data_segments(&input->queue, iov);
+    for (int i = 0; i < segments; ++i)
+    {
+        input_scan(input, hooks, param, iov[i].iov_base, iov[i].iov_len);
+    }
+    ring_consume(&input->queue, ring_avail_to_read(&input->queue));
+    return INPUT_SUCCESS;
+}
+
+
+/*
+* Runs a chunk through the transition table,
+* only transitions that carry an action leave the loop.
+*/
+static int input_scan(input_t *const input, const input_hooks_t *const hooks, void *const param,
+        const unsigned char *const data, const size_t size)
+{
+    input_sm_t *const sm = &input->state_machine;
+
+    size_t i = 0;
+    while (i < size)
+    {
+        if (PS_PASTE == sm->state)
+        {
+            /* nothing but ESC can end the paste */
+            const unsigned char *const esc = memchr(&data[i], '\x1b', size - i);
+            const size_t end = esc ? (size_t)(esc - data) : size;
+            paste_append(&input->paste, &data[i], end - i);
+            i = end;
+            if (!esc) break;
+        }
+
+        const unsigned char ch = data[i++];
+        const parser_state_t from = sm->state;
+        const parser_transition_t transition = g_parser_table[from][ch];
+        sm->state = transition.next;
+
+        if (PA_NONE != transition.action)
+        {
+            input_act(input, hooks, param, transition.action, from, ch);
+        }
+    }
 
-    const size_t bytes = circbuf_read(input->queue, to_process, &buffer);
-    for (size_t i = 0; i < bytes ; ++i)
+    /* a sequence that ends a chunk is either complete by itself or split, time tells */
+    if (PS_GROUND != sm->state && PS_PASTE != sm->state)
     {
-        int status = input_feed(input, hooks, param, buffer[i]);
-        if (status) return status;
+        arm_escape(input);
     }
     return INPUT_SUCCESS;
 }
 
 
-static int input_feed(input_t *const input, const input_hooks_t *const hooks,
-        void *const param, const char ch)
+static void input_act(input_t *const input, const input_hooks_t *const hooks, void *const param,
+        const parser_action_t action, const parser_state_t from, const unsigned char ch)
 {
-    input_sm_t *sm = &input->state_machine;
-    keystroke_event_t *ke = &input->keystroke_mode.keystroke;
+    input_sm_t *const sm = &input->state_machine;
+    keystroke_event_t *const ke = &input->keystroke_mode.keystroke;
 
-    ke->stroke = 0;
-    switch (sm->state)
+    switch (action)
     {
-        case S0: S_LOG(LOGGER_DEBUG, "\n");
-            ke->modifier = 0; /* reset modifier */
-            switch (ch)
-            {
-                case '\x1b':S_LOG(LOGGER_DEBUG, "ESC ");
-                            sm->state = S1;
-                            ke->stroke = ch;
-                            sm->escape_pressed = true;
-                            break;
-
-                case '\x7f':S_LOG(LOGGER_DEBUG, "BACKSPACE\n");
-                            sm->state = S0;
-                            *ke = make_ascii_event(ch);
-                            ke->stroke = '\0';
-                            handle_keyboard(input, hooks, param);
-                            break;
-
-                default:    sm->state = S0;
-                            if (isascii(ch))
-                            {
-                                *ke = make_ascii_event(ch);
-                                handle_keyboard(input, hooks, param);
-                            }
-            }
+        case PA_NONE:
             break;
 
-        case S1:
-            switch (ch)
-            {
-                case '\x1b':S_LOG(LOGGER_DEBUG, "ESC ");
-                            sm->state = S0;
-                            ke->code = KEY_ESC;
-                            break; /* escape pressed */
-
-                case '[':   S_LOG(LOGGER_DEBUG, "[ ");
-                            sm->state = S2;
-                            break;
-
-                /* F1 - F4, no mod */
-                case 'O':   S_LOG(LOGGER_DEBUG, "O ");
-                            sm->state = S24;
-                            break;
-
-                default:    sm->state = S0;
-                            *ke = make_ascii_event(ch);
-                            ke->modifier |= MOD_ALT;
-                            handle_keyboard(input, hooks, param);
-            }
+        case PA_KEY:
+            *ke = g_ascii_events[ch];
+            if ('\x7f' == ch) ke->stroke = '\0'; /* backspace */
+            handle_keyboard(input, hooks, param);
             break;
 
-        case S2:
-            switch (ch)
-            {
-                case '0':   S_LOG(LOGGER_DEBUG, "0 ");
-                            sm->state = S0;
-                            break;
-
-                case '1':   S_LOG(LOGGER_DEBUG, "1 ");
-                            sm->state = S15;
-                            break;
-
-                case '2':   S_LOG(LOGGER_DEBUG, "2 ");
-                            sm->state = S6;
-                            break;
-
-                case '3':   S_LOG(LOGGER_DEBUG, "3 ");
-                            ke->code = KEY_DELETE;
-                            sm->state = S21;
-                            break;
-
-                case '5': case '6':
-                            sm->state = S18;
-                            *ke = make_nav_event(ch, ke->modifier);
-                            break;
-
-                case 'M':   sm->state = S3;
-                            break;
-
-                case 'A': case 'B': case 'C':
-                case 'D': case 'F': case 'H':
-                            sm->state = S0;
-                            *ke = make_nav_event(ch, ke->modifier);
-                            handle_keyboard(input, hooks, param);
-                            break;
-
-                default: FEED_ERROR(ch);
-            }
+        case PA_UTF8_LEAD:
+            sm->utf8_length = (ch >= 0xf0) ? 4 : (ch >= 0xe0) ? 3 : 2;
+            sm->codepoint = ch & (0x7f >> sm->utf8_length);
             break;
 
-        /* MOUSE EVENT PROCESSING */
-        case S3:
-                    sm->state = S4;
-                    input->event_buf[0] = ch;
-                    break;
-        case S4:
-                    sm->state = S5;
-                    input->event_buf[1] = ch;
-                    break;
-        case S5:
-                    sm->state = S0;
-                    input->event_buf[2] = ch;
-                    handle_mouse(input, hooks, param);
-                    break;
-
-        /* PASTE SEQUENCE and FK */
-        case S6:
-            switch (ch)
-            {
-                case '0':   S_LOG(LOGGER_DEBUG, "0 ");
-                            sm->state = S7;
-                            break;
- 
-                case '1': case '3': case '4': S_LOG(LOGGER_DEBUG, "%c ", ch);
-                            sm->state = S21;
-                            *ke = make_fk_event(ch, ke->modifier);
-                            break;
-
-                case '~':   sm->state = S0;
-                            ke->code = KEY_INSERT;
-                            ke->stroke = '\0';
-                            handle_keyboard(input, hooks, param);
-                            break;
-
-                default:    FEED_ERROR(ch);
-            }
+        case PA_UTF8_CONT:
+            sm->codepoint = (sm->codepoint << 6) | (ch & 0x3f);
             break;
 
-        case S7:
-            switch (ch)
-            {
-                case '0':   S_LOG(LOGGER_DEBUG, "0 ");
-                            sm->state = S8;
-                            break;
-
-                /* Edge case for <F9> { */
-                case ';':   S_LOG(LOGGER_DEBUG, "; ");
-                            sm->state = S22;
-                            *ke = make_fk_event('0', ke->modifier);
-                            break;
-
-                case '~':   S_LOG(LOGGER_DEBUG, "~\n");
-                            sm->state = S0;
-                            *ke = make_fk_event('0', ke->modifier);
-                            handle_keyboard(input, hooks, param);
-                            break;
-                /* } */
-                default:    FEED_ERROR(ch);
-            }
+        case PA_UTF8_END:
+            sm->codepoint = (sm->codepoint << 6) | (ch & 0x3f);
+            if (!utf8_valid(sm->codepoint, sm->utf8_length)) break;
+            *ke = (keystroke_event_t){ .code = KEY_CHAR, .stroke = sm->codepoint };
+            handle_keyboard(input, hooks, param);
             break;
 
-        case S8:
-            switch (ch)
-            {
-                case '~':   S_LOG(LOGGER_DEBUG, "~\n");
-                            sm->state = S9;
-                            break;
-                default:    FEED_ERROR(ch);
-            }
+        case PA_ESC_KEY:
+            *ke = g_ascii_events['\x1b'];
+            handle_keyboard(input, hooks, param);
             break;
 
-        case S9:
-            switch (ch)
-            {
-                case '\x1b':S_LOG(LOGGER_DEBUG, "\nESC ");
-                            sm->state = S10;
-                            break;
-                default:    S_LOG(LOGGER_DEBUG, "%x", ch); // TODO: store pasted text
-            }
+        case PA_ALT_KEY:
+            *ke = g_ascii_events[ch];
+            ke->modifier |= MOD_ALT;
+            handle_keyboard(input, hooks, param);
             break;
 
-        case S10:
-            switch (ch)
-            {
-                case '[':   S_LOG(LOGGER_DEBUG, "[ ");
-                            sm->state = S11;
-                            break;
-                default:    FEED_ERROR(ch);
-            }
+        case PA_CSI_START:
+            sm->private_marker = 0;
+            sm->intermediate = 0;
+            sm->params_count = 0;
+            sm->sub_index = 0;
+            sm->params[0] = 0;
+            sm->subparams[0] = 0;
             break;
 
-        case S11:
-            switch (ch)
-            {
-                case '2':   S_LOG(LOGGER_DEBUG, "2 ");
-                            sm->state = S12;
-                            break;
-                default:    FEED_ERROR(ch);
-            }
+        case PA_PARAM_DIGIT:
+        {
+            if (sm->sub_index > 1) break; /* only the first sub-parameter is kept */
+            unsigned int *const value = sm->sub_index
+                ? &sm->subparams[sm->params_count]
+                : &sm->params[sm->params_count];
+            if (*value < PARAM_VALUE_LIMIT) *value = *value * 10 + (ch - '0');
             break;
+        }
 
-        case S12:
-            switch (ch)
+        case PA_PARAM_NEXT:
+            if (sm->params_count + 1 < PARSER_PARAMS_MAX)
             {
-                case '0':   S_LOG(LOGGER_DEBUG, "0 ");
-                            sm->state = S13;
-                            break;
-                default:    FEED_ERROR(ch);
+                ++sm->params_count;
+                sm->params[sm->params_count] = 0;
+                sm->subparams[sm->params_count] = 0;
             }
+            sm->sub_index = 0;
             break;
 
-        case S13:
-            switch (ch)
-            {
-                case '1':   S_LOG(LOGGER_DEBUG, "1 ");
-                            sm->state = S14;
-                            break;
-                default:    FEED_ERROR(ch);
-            }
+        case PA_PARAM_SUB:
+            if (sm->sub_index < UCHAR_MAX) ++sm->sub_index;
             break;
 
-        case S14:
-            switch (ch)
-            {
-                case '~':   S_LOG(LOGGER_DEBUG, "~\n");
-                            sm->state = S0;
-                            S_LOG(LOGGER_DEBUG, "PASTE_END\n");/* TODO confirm paste */
-                            break;
-                default:    FEED_ERROR(ch);
-            }
+        case PA_PRIVATE:
+            sm->private_marker = ch;
             break;
 
-        case S15:
-            switch (ch)
-            {
-                case ';':   S_LOG(LOGGER_DEBUG, "; ");
-                            sm->state = S16;
-                            break;
+        case PA_INTERMEDIATE:
+            sm->intermediate = ch;
+            break;
 
-                case '5': case '7': case '8': case '9':
-                            S_LOG(LOGGER_DEBUG, "%c ", ch);
-                            sm->state = S21;
-                            *ke = make_fk_event(ch, ke->modifier);
-                            break;
+        case PA_CSI_DISPATCH:
+            csi_dispatch(input, hooks, param, ch);
+            break;
 
-                default:    FEED_ERROR(ch);
-            }
+        case PA_SS3_DISPATCH:
+            ss3_dispatch(input, hooks, param, ch);
             break;
 
-        case S16:   sm->state = S17;
-                    ke->modifier = (ch - 0x31) & 0x7;  /*3 bits*/
-                    S_LOG(LOGGER_DEBUG, "mod(%d) ", ke->modifier);
-                    break;
+        case PA_MOUSE_BYTE:
+            input->event_buf[from - PS_MOUSE_1] = ch;
+            break;
 
-        case S17:
-            switch (ch)
-            {
-                case 'P': case 'Q': case 'R': case 'S':
-                            *ke = make_fk_event(ch, ke->modifier);
-                            handle_keyboard(input, hooks, param);
-                            break;
+        case PA_MOUSE_X10:
+            input->event_buf[2] = ch;
+            handle_mouse(input, hooks, param, decode_mouse_event(input->event_buf[0],
+                    input->event_buf[1] - MOUSE_OFFSET, input->event_buf[2] - MOUSE_OFFSET));
+            break;
 
-                default:    *ke = make_nav_event(ch, ke->modifier);
-                            handle_keyboard(input, hooks, param);
-            }
-            sm->state = S0;
+        case PA_PASTE_MISMATCH:
+        {
+            /* `from` tells how much of ESC [ 201 was matched */
+            static const char terminator[] = ESC "[201";
+            paste_append(&input->paste, terminator, from - PS_PASTE_ESC + 1);
+            if ('\x1b' != ch) paste_append(&input->paste, &ch, 1);
             break;
+        }
 
-        case S18:
-            switch (ch)
-            {
-                case ';':   S_LOG(LOGGER_DEBUG, "; ");
-                            sm->state = S19;
-                            break;
+        case PA_PASTE_END:
+            paste_end(input, hooks, param);
+            break;
+    }
+}
 
-                case '~':   S_LOG(LOGGER_DEBUG, "~\n");
-                            sm->state = S0;
-                            // S_LOG(LOGGER_DEBUG, "[%c %x]\n", ch, ch);
-                            handle_keyboard(input, hooks, param);
-                            break;
 
-                default:    FEED_ERROR(ch);
-            }
-            break;
+/*
+* ESC [ params final, modifier comes as the second parameter (1 + mod bits).
+*/
+static void csi_dispatch(input_t *const input, const input_hooks_t *const hooks, void *const param,
+        const unsigned char final)
+{
+    input_sm_t *const sm = &input->state_machine;
+    keystroke_event_t *const ke = &input->keystroke_mode.keystroke;
+    const unsigned int *const p = sm->params;
+    const input_modifier_t mod = (sm->params_count >= 1 && p[1]) ? (p[1] - 1) & 0x7 : MOD_NONE;
 
-        case S19:
-            sm->state = S20;
-            ke->modifier = (ch - 0x31) & 0x7;  /*3 bits*/
-            S_LOG(LOGGER_DEBUG, "mod(%d) ", ke->modifier);
+    if ('<' == sm->private_marker && ('M' == final || 'm' == final))
+    {
+        /* SGR mouse: ESC [ < button ; col ; row M, release ends with m */
+        if (sm->params_count < 2) return;
+        unsigned int code = p[0] + MOUSE_OFFSET;
+        if ('m' == final) code |= MOUSE_NONE; /* X10 reports release that way */
+        handle_mouse(input, hooks, param, decode_mouse_event(code, p[1], p[2]));
+        return;
+    }
+    if ('?' == sm->private_marker && '$' == sm->intermediate && 'y' == final)
+    {
+        mode_reply(input, p[0], p[1]);
+        return;
+    }
+    if (sm->intermediate) return;
+    if ('?' == sm->private_marker)
+    {
+        keyboard_reply(input, final);
+        return;
+    }
+    if (sm->private_marker) return; /* nothing else is expected yet */
+
+    switch (final)
+    {
+        case 'A': case 'B': case 'C':
+        case 'D': case 'F': case 'H':
+            *ke = make_nav_event(final, mod);
             break;
 
-        case S20:
-            switch (ch)
-            {
-                case '~':   S_LOG(LOGGER_DEBUG, "~\n");
-                            sm->state = S0;
-                            handle_keyboard(input, hooks, param);
-                            break;
+        case 'P': case 'Q': case 'R': case 'S':
+            *ke = make_fk_event(final, mod);
+            break;
 
-                default:    FEED_ERROR(ch);
-            }
+        case 'Z':
+            *ke = (keystroke_event_t){ .code = KEY_TAB, .modifier = MOD_SHIFT };
             break;
 
-        case S21:
-            switch (ch)
+        case '~':
+            if (PASTE_BEGIN == p[0])
             {
-                case ';':   S_LOG(LOGGER_DEBUG, "; ");
-                            sm->state = S22;
-                            break;
-
-                case '~':   S_LOG(LOGGER_DEBUG, "~\n");
-                            sm->state = S0;
-                            handle_keyboard(input, hooks, param);
-                            break;
-
-                default:    FEED_ERROR(ch);
+                sm->state = PS_PASTE;
+                return;
             }
+            *ke = (keystroke_event_t){ .modifier = mod };
+            if (!map_tilde(p[0], &ke->code)) return;
             break;
 
-        case S22:
-            sm->state = S21;
-            ke->modifier = (ch - 0x31) & 0x7;  /*3 bits*/
-            S_LOG(LOGGER_DEBUG, "mod(%d) ", ke->modifier);
+        case 'u':
+            if (!make_csi_u_event(p[0], mod, ke)) return;
             break;
 
-        case S23:
-            switch (ch)
-            {
-                case '~':   S_LOG(LOGGER_DEBUG, "~\n");
-                            sm->state = S0;
-                            handle_keyboard(input, hooks, param);
-                            break;
+        default:
+            return; /* not supported */
+    }
+    /* event type is a sub-parameter of modifiers: 1 press, 2 repeat, 3 release */
+    ke->released = sm->params_count >= 1 && 3 == sm->subparams[1];
+    handle_keyboard(input, hooks, param);
+}
 
-                default:    FEED_ERROR(ch);
-            }
+
+/*
+* ESC [ ? flags u answers the keyboard query, so the enhancement is pushed.
+* ESC [ ? ... c (DA) comes last, without the former the terminal is legacy.
+*/
+static void keyboard_reply(input_t *const input, const unsigned char final)
+{
+    if (KEYBOARD_UNKNOWN != input->keyboard) return;
+
+    if ('u' == final)
+    {
+        input->keyboard = KEYBOARD_KITTY;
+        printf(KEYBOARD_PUSH);
+        fflush(stdout);
+    }
+    else if ('c' == final)
+    {
+        input->keyboard = KEYBOARD_LEGACY;
+    }
+}
+
+
+/*
+* ESC [ ? mode ; value $ y (DECRPM), value 0 means the mode is unknown,
+* 1 to 4 - set, reset, permanently set and permanently reset.
+*/
+static void mode_reply(input_t *const input, const unsigned int mode, const unsigned int value)
+{
+    if (LR_MARGINS_MODE == mode)
+    {
+        input->lr_margins = value >= 1 && value <= 3;
+    }
+}
+
+
+/* ESC O final, F1-F4 and cursor keys in application mode */
+static void ss3_dispatch(input_t *const input, const input_hooks_t *const hooks, void *const param,
+        const unsigned char final)
+{
+    keystroke_event_t *const ke = &input->keystroke_mode.keystroke;
+    switch (final)
+    {
+        case 'P': case 'Q': case 'R': case 'S':
+            *ke = make_fk_event(final, MOD_NONE);
             break;
 
-        case S24:
-            sm->state = S0;
-            *ke = make_fk_event(ch, ke->modifier);
-            handle_keyboard(input, hooks, param);
+        case 'A': case 'B': case 'C':
+        case 'D': case 'F': case 'H':
+            *ke = make_nav_event(final, MOD_NONE);
             break;
 
-        default:    FEED_ERROR(ch);
+        default:
+            return;
     }
+    handle_keyboard(input, hooks, param);
+}
 
-    return INPUT_SUCCESS;
+
+static void arm_escape(input_t *const input)
+{
+    input_sm_t *const sm = &input->state_machine;
+    if (sm->escape_timer) timers_cancel(&input->timers, sm->escape_timer);
+    sm->escape_timer = timers_add(&input->timers, INPUT_ESC_TIMEOUT, 0, escape_expired, input);
 }
 
 
-static void handle_mouse(input_t *const input, const input_hooks_t *const hooks, void *const param)
+static void handle_mouse(input_t *const input, const input_hooks_t *const hooks, void *const param,
+        const mouse_event_t event)
 {
     mouse_mode_t *mouse_mode = &input->mouse_mode;
-    mouse_event_t event = decode_mouse_event(input->event_buf);
     // print_mouse_event(&event);
 
     mouse_mode->prev_mouse_event = mouse_mode->last_mouse_event;
@@ -620,7 +835,7 @@ static void handle_mouse(input_t *const input, const input_hooks_t *const hooks,
         && MOUSE_NONE != last->mouse_button)
     {
         mouse_mode->mouse_pressed = *last;
-        hooks->on_press(&mouse_mode->mouse_pressed, param);
+        push_mouse(input, hooks, param, INPUT_EVENT_PRESS, NULL, &mouse_mode->mouse_pressed);
     }
 
     if ( MOUSE_STATIC == prev->motion
@@ -630,17 +845,17 @@ static void handle_mouse(input_t *const input, const input_hooks_t *const hooks,
             && MOUSE_NONE != last->mouse_button)
         {
             mouse_mode->drag = true;
-            hooks->on_drag_begin(&mouse_mode->mouse_pressed, param);
+            push_mouse(input, hooks, param, INPUT_EVENT_DRAG_BEGIN, NULL, &mouse_mode->mouse_pressed);
         }
     }
 
     if (mouse_mode->drag)
     {
-        hooks->on_drag(&mouse_mode->mouse_pressed, &mouse_mode->last_mouse_event, param);
+        push_mouse(input, hooks, param, INPUT_EVENT_DRAG, &mouse_mode->mouse_pressed, last);
     }
     else if (MOUSE_MOVING == last->motion)
     {
-        hooks->on_hover(&mouse_mode->last_mouse_event, param);
+        push_mouse(input, hooks, param, INPUT_EVENT_HOVER, NULL, last);
     }
 
     if ( (MOUSE_STATIC == prev->motion || MOUSE_MOVING == prev->motion)
@@ -651,12 +866,13 @@ static void handle_mouse(input_t *const input, const input_hooks_t *const hooks,
         {
             if (!mouse_mode->drag)
             {
-                hooks->on_release(&mouse_mode->mouse_pressed, param);
+                push_mouse(input, hooks, param, INPUT_EVENT_RELEASE, NULL, &mouse_mode->mouse_pressed);
             }
             else
             {
                 mouse_mode->drag = false;
-                hooks->on_drag_end(&mouse_mode->mouse_pressed, &mouse_mode->mouse_released, param);
+                push_mouse(input, hooks, param, INPUT_EVENT_DRAG_END,
+                        &mouse_mode->mouse_pressed, &mouse_mode->mouse_released);
             }
             mouse_mode->mouse_released = *last;
         }
@@ -664,26 +880,210 @@ static void handle_mouse(input_t *const input, const input_hooks_t *const hooks,
 
     if (MOUSE_SCROLLING == last->motion)
     {
-        hooks->on_scroll(last, param);
+        push_mouse(input, hooks, param, INPUT_EVENT_SCROLL, NULL, last);
+    }
+}
+
+
+static void push_event(input_t *const input, const input_hooks_t *const hooks, void *const param,
+        const input_event_t event)
+{
+    if (INPUT_BATCH_SIZE == input->batch_size)
+    {
+        flush_batch(input, hooks, param);
+    }
+    input->batch[input->batch_size++] = event;
+}
+
+
+static void push_mouse(input_t *const input, const input_hooks_t *const hooks, void *const param,
+        const input_event_type_t type, const mouse_event_t *const begin, const mouse_event_t *const mouse)
+{
+    input_event_t event = { .type = type, .mouse = *mouse };
+    if (begin) event.begin = *begin;
+    push_event(input, hooks, param, event);
+}
+
+
+static void flush_batch(input_t *const input, const input_hooks_t *const hooks, void *const param)
+{
+    coalesce_batch(input->batch, input->batch_size);
+    for (size_t i = 0; i < input->batch_size; ++i)
+    {
+        dispatch_event(input, &input->batch[i], hooks, param);
+    }
+    input->batch_size = 0;
+
+    /* only a paste still being collected is left */
+    paste_buffer_t *const paste = &input->paste;
+    if (paste->begin)
+    {
+        memmove(paste->data, paste->data + paste->begin, paste->size - paste->begin);
+        paste->size -= paste->begin;
+        paste->begin = 0;
+    }
+}
+
+
+static void paste_append(paste_buffer_t *const paste, const void *const data, const size_t size)
+{
+    if (paste->size + size > paste->capacity)
+    {
+        size_t capacity = paste->capacity ? paste->capacity : INPUT_PASTE_INITIAL_CAP;
+        while (capacity < paste->size + size) capacity *= 2;
+
+        char *grown = realloc(paste->data, capacity);
+        if (!grown)
+        {
+            perror("paste_append");
+            exit(EXIT_FAILURE);
+        }
+        paste->data = grown;
+        paste->capacity = capacity;
+    }
+    memcpy(paste->data + paste->size, data, size);
+    paste->size += size;
+}
+
+
+static void paste_end(input_t *const input, const input_hooks_t *const hooks, void *const param)
+{
+    /* pushed first, a full batch is flushed and moves the paste to the front */
+    push_event(input, hooks, param, (input_event_t){ .type = INPUT_EVENT_PASTE });
+
+    paste_buffer_t *const paste = &input->paste;
+    input_event_t *const event = &input->batch[input->batch_size - 1];
+    event->paste.offset = paste->begin;
+    event->paste.size = paste->size - paste->begin;
+    paste->begin = paste->size;
+}
+
+
+/*
+* Drops motion that is superseded by a later one of the same kind,
+* other mouse events are barriers, so press/release order is kept.
+* Keystrokes are no barrier: keys pending behind a hover flood go first.
+* Then identical navigation keys in a row are merged into one with a repeat count.
+*/
+static void coalesce_batch(input_event_t batch[], const size_t size)
+{
+    bool later_hover = false;
+    bool later_drag = false;
+    for (size_t i = size; i-- > 0;)
+    {
+        switch (batch[i].type)
+        {
+            case INPUT_EVENT_HOVER:
+                if (later_hover) batch[i].type = INPUT_EVENT_NONE;
+                later_hover = true;
+                break;
+
+            case INPUT_EVENT_DRAG:
+                if (later_drag) batch[i].type = INPUT_EVENT_NONE;
+                later_drag = true;
+                break;
+
+            case INPUT_EVENT_KEYSTROKE:
+            case INPUT_EVENT_PASTE:
+            case INPUT_EVENT_NONE:
+                break;
+
+            default:
+                later_hover = false;
+                later_drag = false;
+        }
+    }
+
+    input_event_t *last_key = NULL;
+    for (size_t i = 0; i < size; ++i)
+    {
+        if (INPUT_EVENT_NONE == batch[i].type) continue;
+
+        if (INPUT_EVENT_KEYSTROKE == batch[i].type)
+        {
+            if (last_key && is_repeatable(&last_key->keystroke, &batch[i].keystroke))
+            {
+                last_key->keystroke.repeat += batch[i].keystroke.repeat;
+                batch[i].type = INPUT_EVENT_NONE;
+                continue;
+            }
+            last_key = &batch[i];
+        }
+        else
+        {
+            last_key = NULL;
+        }
+    }
+}
+
+
+static void dispatch_event(const input_t *const input, const input_event_t *const event,
+        const input_hooks_t *const hooks, void *const param)
+{
+    switch (event->type)
+    {
+        case INPUT_EVENT_NONE:       break;
+        case INPUT_EVENT_KEYSTROKE:  hooks->on_keystroke(&event->keystroke, param); break;
+        case INPUT_EVENT_HOVER:      hooks->on_hover(&event->mouse, param); break;
+        case INPUT_EVENT_PRESS:      hooks->on_press(&event->mouse, param); break;
+        case INPUT_EVENT_RELEASE:    hooks->on_release(&event->mouse, param); break;
+        case INPUT_EVENT_DRAG_BEGIN: hooks->on_drag_begin(&event->mouse, param); break;
+        case INPUT_EVENT_DRAG:       hooks->on_drag(&event->begin, &event->mouse, param); break;
+        case INPUT_EVENT_DRAG_END:   hooks->on_drag_end(&event->begin, &event->mouse, param); break;
+        case INPUT_EVENT_SCROLL:     hooks->on_scroll(&event->mouse, param); break;
+        case INPUT_EVENT_PASTE:
+        {
+            const paste_event_t paste = {
+                .data = input->paste.data + event->paste.offset,
+                .size = event->paste.size,
+            };
+            hooks->on_paste(&paste, param);
+            break;
+        }
+    }
+}
+
+
+static bool is_repeatable(const keystroke_event_t *const a, const keystroke_event_t *const b)
+{
+    switch (a->code)
+    {
+        case KEY_UP: case KEY_DOWN: case KEY_RIGHT: case KEY_LEFT:
+        case KEY_PAGE_UP: case KEY_PAGE_DOWN:
+            return a->code == b->code
+                && a->modifier == b->modifier
+                && a->stroke == b->stroke
+                && a->released == b->released;
+        default:
+            return false;
     }
 }
 
 
 static void handle_keyboard(input_t *const input, const input_hooks_t *const hooks, void *const param)
 {
-    hooks->on_keystroke(&input->keystroke_mode.keystroke, param);
+    input_event_t event = {
+        .type = INPUT_EVENT_KEYSTROKE,
+        .keystroke = input->keystroke_mode.keystroke,
+    };
+    event.keystroke.repeat = 1;
+    push_event(input, hooks, param, event);
 }
 
 
-static mouse_event_t decode_mouse_event(unsigned char buffer[static 3])
+/*
+* `code` is the button byte as X10 sends it (offset by 0x20),
+* `col` and `row` are one-based.
+*/
+static mouse_event_t decode_mouse_event(const unsigned int code, const unsigned int col, const unsigned int row)
 {
     mouse_event_t event = {
-        .mouse_button = buffer[0] & 0x3,    /*2 bits*/
-        .modifier = (buffer[0] >> 2) & 0x7, /*3 bits*/
-        .motion = (buffer[0] >> 5) & 0x3,   /*2 bits*/
+        .mouse_button = code & 0x3,    /*2 bits*/
+        .modifier = (code >> 2) & 0x7, /*3 bits*/
+        .motion = (code >> 5) & 0x3,   /*2 bits*/
         .position = {
-            (buffer[1] - MOUSE_OFFSET) - 1, /* convert to zero-based */
-            (buffer[2] - MOUSE_OFFSET) - 1, /* convert to zero-based */
+            col ? col - 1 : 0, /* convert to zero-based */
+            row ? row - 1 : 0, /* convert to zero-based */
         },
     };
 
@@ -797,8 +1197,6 @@ static keycode_t map_nav(int ch)
 {
     switch (ch)
     {
-        case '5': S_LOG(LOGGER_DEBUG, "PAGE UP ");   return KEY_PAGE_UP;
-        case '6': S_LOG(LOGGER_DEBUG, "PAGE DOWN "); return KEY_PAGE_DOWN;
         case 'A': S_LOG(LOGGER_DEBUG, "UP ");        return KEY_UP;
         case 'B': S_LOG(LOGGER_DEBUG, "DOWN ");      return KEY_DOWN;
         case 'C': S_LOG(LOGGER_DEBUG, "RIGHT ");     return KEY_RIGHT;
@@ -815,20 +1213,64 @@ static keycode_t map_fk(int ch)
 {
     switch (ch)
     {
-        case '\x1b':return KEY_ESC;
         case 'P':   return KEY_F1;
         case 'Q':   return KEY_F2;
         case 'R':   return KEY_F3;
         case 'S':   return KEY_F4;
-        case '5':   return KEY_F5;
-        case '7':   return KEY_F6;
-        case '8':   return KEY_F7;
-        case '9':   return KEY_F8;
-        case '0':   return KEY_F9;
-        case '1':   return KEY_F10;
-        case '3':   return KEY_F11;
-        case '4':   return KEY_F12;
     }
     S_LOG(LOGGER_CRITICAL, "PARSE ERROR: wrong function key!\n");
     return 0;
 }
+
+
+/* ESC [ number ~ */
+/* ESC [ code ; mod u, code is a unicode codepoint of the unshifted key */
+static bool make_csi_u_event(const unsigned int code, const input_modifier_t mod, keystroke_event_t *const ke)
+{
+    if (code >= 0xe000 && code <= 0xf8ff) return false; /* functional keys from the private use area */
+    if (code >= 128)
+    {
+        if (code > 0x10ffff || (0xd800 <= code && code <= 0xdfff)) return false;
+        *ke = (keystroke_event_t){ .code = KEY_CHAR, .stroke = code, .modifier = mod };
+        if (mod & MOD_CTRL) ke->stroke = '\0';
+        return true;
+    }
+
+    switch (code)
+    {
+        case '\r':   *ke = g_ascii_events['\n']; break; /* same as enter in legacy mode */
+        case '\x7f': *ke = g_ascii_events['\x7f']; ke->stroke = '\0'; break;
+        default:
+            *ke = g_ascii_events[(mod & MOD_SHIFT) ? toupper((int)code) : (int)code];
+    }
+    ke->modifier = mod;
+    if (mod & MOD_CTRL) ke->stroke = '\0'; /* not a text */
+    return true;
+}
+
+
+static bool map_tilde(unsigned int number, keycode_t *const code)
+{
+    switch (number)
+    {
+        case 1: case 7:  *code = KEY_HOME;      return true;
+        case 2:          *code = KEY_INSERT;    return true;
+        case 3:          *code = KEY_DELETE;    return true;
+        case 4: case 8:  *code = KEY_END;       return true;
+        case 5:          *code = KEY_PAGE_UP;   return true;
+        case 6:          *code = KEY_PAGE_DOWN; return true;
+        case 11:         *code = KEY_F1;        return true;
+        case 12:         *code = KEY_F2;        return true;
+        case 13:         *code = KEY_F3;        return true;
+        case 14:         *code = KEY_F4;        return true;
+        case 15:         *code = KEY_F5;        return true;
+        case 17:         *code = KEY_F6;        return true;
+        case 18:         *code = KEY_F7;        return true;
+        case 19:         *code = KEY_F8;        return true;
+        case 20:         *code = KEY_F9;        return true;
+        case 21:         *code = KEY_F10;       return true;
+        case 23:         *code = KEY_F11;       return true;
+        case 24:         *code = KEY_F12;       return true;
+    }
+    return false;
+}
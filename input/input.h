@@ -1,15 +1,18 @@
 #ifndef _INPUT_H_
 #define _INPUT_H_
 
-#include "circbuf.h"
 #include "display.h"
 #include "hashmap.h"
 #include "logger.h"
+#include "parser.h"
+#include "ring.h"
+#include "timer.h"
+#include "utf8.h"
 
 #include <stddef.h>
 
-#define INPUT_QUEUE_SIZE  4*1024 // 4kb
-#define INPUT_BUFFER_SIZE 256
+#define INPUT_QUEUE_SIZE  64*1024 // 64kb, power of two
+#define INPUT_FD_QUEUE_SIZE 4*1024 // default for watched descriptors
 
 #ifndef ESC
 #define ESC "\x1b"
@@ -22,11 +25,27 @@
 #define MOUSE_EVENTS_ON     ESC "[?1003h"
 #define MOUSE_EVENTS_OFF    ESC "[?1003l"
 
+/* terminals that know SGR encoding prefer it over X10, others ignore it */
+#define MOUSE_SGR_ON        ESC "[?1006h"
+#define MOUSE_SGR_OFF       ESC "[?1006l"
+
 #define PASTE_MODE_ON       ESC "[?2004h"
 #define PASTE_MODE_OFF      ESC "[?2004l"
 
+/* progressive enhancement keyboard (CSI u), a reply to ?u comes before the DA one */
+#define KEYBOARD_QUERY      ESC "[?u" ESC "[c"
+#define LR_MARGINS_MODE     69
+#define MARGINS_QUERY       ESC "[?69$p" /* DECRQM of DECLRMM, answered before DA */
+#define KEYBOARD_PUSH       ESC "[>3u" /* disambiguate escapes, report event types */
+#define KEYBOARD_POP        ESC "[<u"
+
 #define MOUSE_OFFSET 0x20
 
+#define INPUT_ESC_TIMEOUT  10 /* ms a split sequence waits for the rest of it */
+#define INPUT_DRAIN_ROUNDS 16 /* readiness checks per wait, bounds time spent in a flood */
+#define INPUT_BATCH_SIZE  256 /* events coalesced together before dispatch */
+#define INPUT_PASTE_INITIAL_CAP 4096
+
 typedef enum
 {
     MOUSE_1, SCROLL_UP = MOUSE_1,
@@ -88,6 +107,7 @@ typedef enum
     KEY_Q,    KEY_R,    KEY_S,    KEY_T,
     KEY_U,    KEY_V,    KEY_W,    KEY_X,
     KEY_Y,    KEY_Z,
+    KEY_CHAR, /* any other character, its codepoint is the stroke */
 }
 keycode_t;
 
@@ -96,11 +116,22 @@ typedef struct
 {
     input_modifier_t modifier;
     keycode_t code;
-    int stroke;
+    int stroke;          /* unicode codepoint typed, zero for keys that are not text */
+    unsigned int repeat; /* same navigation key pressed in a row, at least 1 */
+    bool released;       /* reported only by terminals with CSI u keyboard */
 }
 keystroke_event_t;
 
 
+/* Content of a bracketed paste, valid only during the hook call */
+typedef struct
+{
+    const char *data;
+    size_t      size;
+}
+paste_event_t;
+
+
 typedef struct
 {
     input_modifier_t modifier;
@@ -129,66 +160,52 @@ typedef struct
 keystroke_mode_t;
 
 
+/* Parsed event waiting for dispatch */
+typedef enum
+{
+    INPUT_EVENT_NONE = 0, /* dropped by coalescing */
+    INPUT_EVENT_KEYSTROKE,
+    INPUT_EVENT_HOVER,
+    INPUT_EVENT_PRESS,
+    INPUT_EVENT_RELEASE,
+    INPUT_EVENT_DRAG_BEGIN,
+    INPUT_EVENT_DRAG,
+    INPUT_EVENT_DRAG_END,
+    INPUT_EVENT_SCROLL,
+    INPUT_EVENT_PASTE,
+}
+input_event_type_t;
+
+
+typedef struct
+{
+    unsigned char type; /* stores a value of input_event_type_t */
+    union
+    {
+        keystroke_event_t keystroke;
+        struct
+        {
+            mouse_event_t begin; /* of a drag */
+            mouse_event_t mouse;
+        };
+        struct
+        {
+            size_t offset; /* in the paste buffer, that may move until dispatch */
+            size_t size;
+        }
+        paste;
+    };
+}
+input_event_t;
+
+
 typedef enum
 {
-/* MOUSE SEQUENCE                 */
-    S0 = 0x0, /* 00000000         */
-    S1,       /* 00000001 ESC     */
-    S2,       /* 00000010 [       */
-    S3,       /* 00000011 M       */
-    S4,       /* 00000100 event   */
-    S5,       /* 00000101 line    */
-/*  S0           00000000 col     */
-
-/* SPECIAL KEYS:                  */
-/* PASTE SEQUENCE                 */
-/*  S0           00000000         */
-/*  S1           00000001 ESC     */
-/*  S2           00000010 [       */
-    S6 = 0x10,/* 00010000 2       */
-    S7,       /* 00010001 0       */
-    S8,       /* 00010010 0       */
-    S9,       /* 00010011 ~       */
-/*  S9           00010100 *       */  // * - means any character
-    S10,      /* 00010101 ESC     */
-    S11,      /* 00010110 [       */
-    S12,      /* 00010111 2       */
-    S13,      /* 00011000 0       */
-    S14,      /* 00011001 1       */
-/*  S0           00000000 ~       */
-
-/*  S0           00000000         */
-/*  S1           00000001 ESC     */
-/* ARROW KEYS                     */
-/*  S2           00000010 [       */
-    S15 = 0x20,/*00100000 1       */
-    S16,       /*00100001 ;       */
-    S17,       /*00100010 mod     */
-/*  S0           00000000 ~       */
-
-/* OTHER NAV KEYS                 */
-/*  S2           00000010 [       */
-    S18,       /*00100011 5/6/H/F */
-    S19,       /*00100100 ;       !optional */
-    S20,       /*00100101 mod     !-------- */
-/*  S0           00000000 ~       */
-/* DELETE */
-/*  S2           00000010 [       */
-    S21,       /*00100110 3       */
-    S22,       /*00100111 ;       !optional */
-    S23,       /*00101000 mod     !-------- */
-/*  S0           00000000 ~       */
-/*  F-KEYS (F1-F4)                */
-    S24,       /*00101001 O (4f)  */
-    S25,       /*00101010 P/Q/R/S */
-/*  S0           00000000 ~       */
-/*  F-KEYS (F5-F8)                */
-/*  S2           00000010 [       */
-/*  S15 = 0x20,  00100000 1       */
-/*  S21,         00100110 3       */
-/*  S0           00000000 ~       */
-}
-istate_t;
+    KEYBOARD_UNKNOWN = 0, /* waiting for reply to the query */
+    KEYBOARD_LEGACY,
+    KEYBOARD_KITTY,       /* CSI u, ESC and modifiers come unambiguous */
+}
+input_keyboard_t;
 
 
 typedef enum
@@ -203,21 +220,49 @@ input_status_t;
 
 typedef struct
 {
-    unsigned char state; // stores a value of istate_t 1 byte long
-    bool escape_pressed;
+    unsigned char state; // stores a value of parser_state_t 1 byte long
+    unsigned char private_marker; /* '<', '=', '>' or '?' after ESC [, zero if none */
+    unsigned char intermediate;   /* last one before the final byte, zero if none */
+    unsigned char params_count;   /* index of the parameter being collected */
+    unsigned char sub_index;      /* of the sub-parameter being collected, zero for the main value */
+    unsigned int  params[PARSER_PARAMS_MAX];
+    unsigned int  subparams[PARSER_PARAMS_MAX]; /* first sub-parameter of each, ESC [ 1 ; 5 : 3 u */
+    uint32_t      codepoint;      /* of a multibyte character being decoded */
+    unsigned char utf8_length;    /* its length in bytes */
+    timer_id_t    escape_timer;   /* resolves a sequence left unfinished */
 }
 input_sm_t;
 
 
+/* Collects pasted bytes, completed pastes are dispatched from here */
+typedef struct
+{
+    char  *data;
+    size_t size;
+    size_t capacity;
+    size_t begin; /* of the paste being collected */
+}
+paste_buffer_t;
+
+
 typedef struct input
 {
     unsigned char    event_buf[EVENT_BUF_SIZE];
     input_sm_t       state_machine;
-    circbuf_t       *queue;
+    ring_t           queue;
+    input_keyboard_t keyboard;    /* protocol negotiated with the terminal */
+    bool             lr_margins;  /* terminal reported DECLRMM as recognized */
     mouse_mode_t     mouse_mode;
     keystroke_mode_t keystroke_mode;
     int              epfd; /* epoll file descriptor */
-    hashmap_t       *descriptors; /* maps fd to a buffer that receives and outputs */
+    hashmap_t       *descriptors; /* maps watched fd to its descriptor */
+    struct descriptor *watched;   /* all descriptors, for deinit */
+    timers_t         timers;
+    input_event_t    batch[INPUT_BATCH_SIZE];
+    size_t           batch_size;
+    paste_buffer_t   paste;
+    const struct input_hooks *hooks; /* of the wait in progress, for timer callbacks */
+    void            *param;
 }
 input_t;
 
@@ -233,16 +278,39 @@ typedef struct input_hooks
         const mouse_event_t *const end, void *const param);
     void (*on_scroll)(const mouse_event_t *const scroll, void *const param);
     void (*on_keystroke)(const keystroke_event_t *const keystroke, void *const param);
+    void (*on_paste)(const paste_event_t *const paste, void *const param);
 }
 input_hooks_t;
 
 
+/*
+* Called when a watched fd has data or got closed.
+* `queue` holds what was read and not consumed yet, the callback
+* takes what it needs with ring_data_segments and ring_consume.
+* A closed fd is unwatched right after, closing it is up to the owner.
+*/
+typedef void (*input_fd_callback_t)(input_t *const input, const int fd, ring_t *const queue,
+        const bool closed, void *const data);
+
+
 input_t input_init(void);
 void input_deinit(input_t *const input);
 void input_enable_mouse(void);
 void input_disable_mouse(void);
 int input_handle_events(input_t *const input, const input_hooks_t *const hooks, void *const param);
+int input_wait_events(input_t *const input, const input_hooks_t *const hooks, void *const param, int timeout);
 void input_display_overlay(input_t *const input, disp_pos_t pos);
 
+/*
+* Services `fd` (pipe, socket, pty, eventfd...) from the input loop,
+* it is switched to non-blocking and read into a ring of `queue_size` bytes,
+* zero picks INPUT_FD_QUEUE_SIZE. Returns INPUT_ERROR if fd can not be watched.
+*/
+int input_watch_fd(input_t *const input, const int fd, const size_t queue_size,
+        input_fd_callback_t callback, void *const data);
+
+/* Stops watching, safe to call from the callback */
+void input_unwatch_fd(input_t *const input, const int fd);
+
 
 #endif//_INPUT_H_
@@ -108,6 +108,13 @@ static void on_keystroke(const keystroke_event_t *const keystroke, void *const p
 }
 
 
+static void on_paste(const paste_event_t *const paste, void *const param)
+{
+    (void) param;
+    printf("paste %zu bytes: \"%.*s\"\n", paste->size, (int)paste->size, paste->data);
+}
+
+
 int main(void)
 {
     input_hooks_t hooks = {
@@ -119,6 +126,7 @@ int main(void)
         .on_drag_end = on_drag_end,
         .on_scroll = on_scroll,
         .on_keystroke = on_keystroke,
+        .on_paste = on_paste,
     };
     input_enable_mouse();
     input_t input = input_init();
@@ -0,0 +1,114 @@
+#include "parser.h"
+
+#define T(to, act) { .next = (to), .action = (act) }
+
+/* rows of CSI_ENTRY and CSI_PARAM that are the same */
+#define CSI_COMMON \
+    [0x00 ... 0x1a]   = T(PS_CSI_PARAM, PA_NONE), /* C0 is ignored */ \
+    [0x1c ... 0x1f]   = T(PS_CSI_PARAM, PA_NONE), \
+    [0x1b]            = T(PS_ESCAPE, PA_NONE), \
+    [0x20 ... 0x2f]   = T(PS_CSI_INTER, PA_INTERMEDIATE), \
+    ['0' ... '9']     = T(PS_CSI_PARAM, PA_PARAM_DIGIT), \
+    [':']             = T(PS_CSI_PARAM, PA_PARAM_SUB), \
+    [';']             = T(PS_CSI_PARAM, PA_PARAM_NEXT), \
+    ['<' ... '?']     = T(PS_CSI_IGNORE, PA_NONE), \
+    [0x40 ... 0x7e]   = T(PS_GROUND, PA_CSI_DISPATCH), \
+    [0x7f ... 0xff]   = T(PS_GROUND, PA_NONE)
+
+/* byte that can't continue a character is taken as if from the ground */
+#define GROUND_ROW \
+    [0x00 ... 0x7f]   = T(PS_GROUND, PA_KEY), \
+    [0x80 ... 0xff]   = T(PS_GROUND, PA_NONE), /* stray or invalid */ \
+    [0xc2 ... 0xdf]   = T(PS_UTF8_1, PA_UTF8_LEAD), \
+    [0xe0 ... 0xef]   = T(PS_UTF8_2, PA_UTF8_LEAD), \
+    [0xf0 ... 0xf4]   = T(PS_UTF8_3, PA_UTF8_LEAD), \
+    [0x1b]            = T(PS_ESCAPE, PA_NONE)
+
+/* anything that breaks a paste terminator is content */
+#define PASTE_MISMATCH \
+    [0x00 ... 0xff]   = T(PS_PASTE, PA_PASTE_MISMATCH), \
+    [0x1b]            = T(PS_PASTE_ESC, PA_PASTE_MISMATCH)
+
+const parser_transition_t g_parser_table[PS_COUNT][256] = {
+    [PS_GROUND] = {
+        GROUND_ROW,
+    },
+    [PS_UTF8_1] = {
+        GROUND_ROW,
+        [0x80 ... 0xbf] = T(PS_GROUND, PA_UTF8_END),
+    },
+    [PS_UTF8_2] = {
+        GROUND_ROW,
+        [0x80 ... 0xbf] = T(PS_UTF8_1, PA_UTF8_CONT),
+    },
+    [PS_UTF8_3] = {
+        GROUND_ROW,
+        [0x80 ... 0xbf] = T(PS_UTF8_2, PA_UTF8_CONT),
+    },
+    [PS_ESCAPE] = {
+        [0x00 ... 0x7f] = T(PS_GROUND, PA_ALT_KEY),
+        [0x80 ... 0xff] = T(PS_GROUND, PA_NONE),
+        [0x1b]          = T(PS_ESCAPE, PA_ESC_KEY),
+        ['[']           = T(PS_CSI_ENTRY, PA_CSI_START),
+        ['O']           = T(PS_SS3, PA_NONE),
+    },
+    [PS_SS3] = {
+        [0x00 ... 0xff] = T(PS_GROUND, PA_NONE),
+        [0x1b]          = T(PS_ESCAPE, PA_NONE),
+        [0x40 ... 0x7e] = T(PS_GROUND, PA_SS3_DISPATCH),
+    },
+    [PS_CSI_ENTRY] = {
+        CSI_COMMON,
+        ['<' ... '?']   = T(PS_CSI_PARAM, PA_PRIVATE),
+        ['M']           = T(PS_MOUSE_1, PA_NONE),
+    },
+    [PS_CSI_PARAM] = {
+        CSI_COMMON,
+    },
+    [PS_CSI_INTER] = {
+        [0x00 ... 0xff] = T(PS_CSI_IGNORE, PA_NONE), /* params can't follow */
+        [0x1b]          = T(PS_ESCAPE, PA_NONE),
+        [0x20 ... 0x2f] = T(PS_CSI_INTER, PA_INTERMEDIATE),
+        [0x40 ... 0x7e] = T(PS_GROUND, PA_CSI_DISPATCH),
+        [0x7f ... 0xff] = T(PS_GROUND, PA_NONE),
+    },
+    [PS_CSI_IGNORE] = {
+        [0x00 ... 0xff] = T(PS_CSI_IGNORE, PA_NONE),
+        [0x1b]          = T(PS_ESCAPE, PA_NONE),
+        [0x40 ... 0x7e] = T(PS_GROUND, PA_NONE),
+    },
+    [PS_MOUSE_1] = {
+        [0x00 ... 0xff] = T(PS_MOUSE_2, PA_MOUSE_BYTE),
+    },
+    [PS_MOUSE_2] = {
+        [0x00 ... 0xff] = T(PS_MOUSE_3, PA_MOUSE_BYTE),
+    },
+    [PS_MOUSE_3] = {
+        [0x00 ... 0xff] = T(PS_GROUND, PA_MOUSE_X10),
+    },
+    [PS_PASTE] = {
+        /* content is collected in bulk, only ESC gets here */
+        [0x00 ... 0xff] = T(PS_PASTE, PA_NONE),
+        [0x1b]          = T(PS_PASTE_ESC, PA_NONE),
+    },
+    [PS_PASTE_ESC] = {
+        PASTE_MISMATCH,
+        ['[']           = T(PS_PASTE_CSI, PA_NONE),
+    },
+    [PS_PASTE_CSI] = {
+        PASTE_MISMATCH,
+        ['2']           = T(PS_PASTE_2, PA_NONE),
+    },
+    [PS_PASTE_2] = {
+        PASTE_MISMATCH,
+        ['0']           = T(PS_PASTE_20, PA_NONE),
+    },
+    [PS_PASTE_20] = {
+        PASTE_MISMATCH,
+        ['1']           = T(PS_PASTE_201, PA_NONE),
+    },
+    [PS_PASTE_201] = {
+        PASTE_MISMATCH,
+        ['~']           = T(PS_GROUND, PA_PASTE_END),
+    },
+};
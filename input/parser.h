@@ -0,0 +1,72 @@
+#ifndef _PARSER_H_
+#define _PARSER_H_
+
+#include <stdint.h>
+
+/*
+* Terminal input grammar compiled into a dense transition table.
+* Every byte is one lookup by current state, that yields the next state
+* and an action for the input module to perform.
+*/
+
+#define PARSER_PARAMS_MAX 16
+
+typedef enum
+{
+    PS_GROUND = 0,
+    PS_UTF8_1,      /* one more continuation byte is expected */
+    PS_UTF8_2,      /* two more */
+    PS_UTF8_3,      /* three more */
+    PS_ESCAPE,      /* ESC */
+    PS_SS3,         /* ESC O */
+    PS_CSI_ENTRY,   /* ESC [ */
+    PS_CSI_PARAM,   /* ESC [ params */
+    PS_CSI_INTER,   /* ESC [ params intermediate, such as $ of DECRPM */
+    PS_CSI_IGNORE,  /* unsupported sequence, skipped up to its final byte */
+    PS_MOUSE_1,     /* ESC [ M, X10 mouse: button */
+    PS_MOUSE_2,     /*                     column */
+    PS_MOUSE_3,     /*                     row    */
+    PS_PASTE,       /* bracketed paste content */
+    PS_PASTE_ESC,   /* possible end: ESC       */
+    PS_PASTE_CSI,   /*               ESC [     */
+    PS_PASTE_2,     /*               ESC [ 2   */
+    PS_PASTE_20,    /*               ESC [ 20  */
+    PS_PASTE_201,   /*               ESC [ 201 */
+    PS_COUNT
+}
+parser_state_t;
+
+typedef enum
+{
+    PA_NONE = 0,
+    PA_KEY,          /* plain byte */
+    PA_UTF8_LEAD,    /* first byte of a multibyte character */
+    PA_UTF8_CONT,
+    PA_UTF8_END,     /* last continuation, character is complete */
+    PA_ESC_KEY,      /* ESC ESC, the first one is a key */
+    PA_ALT_KEY,      /* ESC and a byte */
+    PA_CSI_START,
+    PA_PARAM_DIGIT,
+    PA_PARAM_NEXT,
+    PA_PARAM_SUB,    /* ':' starts a sub-parameter */
+    PA_PRIVATE,      /* private marker right after ESC [ */
+    PA_INTERMEDIATE, /* byte between params and the final one */
+    PA_CSI_DISPATCH,
+    PA_SS3_DISPATCH,
+    PA_MOUSE_BYTE,
+    PA_MOUSE_X10,
+    PA_PASTE_MISMATCH, /* bytes taken for a terminator are content */
+    PA_PASTE_END,
+}
+parser_action_t;
+
+typedef struct
+{
+    uint8_t next;   /* stores a value of parser_state_t */
+    uint8_t action; /* stores a value of parser_action_t */
+}
+parser_transition_t;
+
+extern const parser_transition_t g_parser_table[PS_COUNT][256];
+
+#endif/*_PARSER_H_*/
@@ -0,0 +1,96 @@
+#include "parser.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/*
+* Sequences are run through the table from a state,
+* actions taken on the way and the state they end in are compared.
+*/
+
+#define MAX_ACTIONS 16
+#define END (-1) /* terminates the list of expected actions */
+
+
+static void expect(const parser_state_t from, const char *const bytes,
+        const parser_state_t to, const int actions[])
+{
+    parser_state_t state = from;
+    size_t taken = 0;
+    for (const unsigned char *ch = (const unsigned char *)bytes; *ch; ++ch)
+    {
+        const parser_transition_t transition = g_parser_table[state][*ch];
+        assert(transition.next < PS_COUNT);
+        state = transition.next;
+
+        if (PA_NONE == transition.action) continue;
+        assert(taken < MAX_ACTIONS && END != actions[taken]);
+        assert(transition.action == actions[taken]);
+        ++taken;
+    }
+    assert(END == actions[taken]);
+    assert(to == state);
+}
+
+#define EXPECT(from, bytes, to, ...) expect((from), (bytes), (to), (const int[]){ __VA_ARGS__, END })
+
+
+int main(void)
+{
+    /* keys */
+    EXPECT(PS_GROUND, "a\t\x7f", PS_GROUND, PA_KEY, PA_KEY, PA_KEY);
+    EXPECT(PS_GROUND, "\x1b", PS_ESCAPE, END);
+    EXPECT(PS_GROUND, "\x1b\x1b", PS_ESCAPE, PA_ESC_KEY);
+    EXPECT(PS_GROUND, "\x1b" "x", PS_GROUND, PA_ALT_KEY);
+
+    /* utf-8, a broken character gives way to the byte that broke it */
+    EXPECT(PS_GROUND, "\xc3\xa9", PS_GROUND, PA_UTF8_LEAD, PA_UTF8_END);
+    EXPECT(PS_GROUND, "\xe2\x82\xac", PS_GROUND, PA_UTF8_LEAD, PA_UTF8_CONT, PA_UTF8_END);
+    EXPECT(PS_GROUND, "\xf0\x9f\x98\x80", PS_GROUND,
+            PA_UTF8_LEAD, PA_UTF8_CONT, PA_UTF8_CONT, PA_UTF8_END);
+    EXPECT(PS_GROUND, "\xe2" "A", PS_GROUND, PA_UTF8_LEAD, PA_KEY);
+    EXPECT(PS_GROUND, "\x80\xc0\xf5", PS_GROUND, END);
+
+    /* csi */
+    EXPECT(PS_GROUND, "\x1b[A", PS_GROUND, PA_CSI_START, PA_CSI_DISPATCH);
+    EXPECT(PS_GROUND, "\x1b[1;5A", PS_GROUND,
+            PA_CSI_START, PA_PARAM_DIGIT, PA_PARAM_NEXT, PA_PARAM_DIGIT, PA_CSI_DISPATCH);
+    EXPECT(PS_GROUND, "\x1b[97;5:3u", PS_GROUND,
+            PA_CSI_START, PA_PARAM_DIGIT, PA_PARAM_DIGIT, PA_PARAM_NEXT,
+            PA_PARAM_DIGIT, PA_PARAM_SUB, PA_PARAM_DIGIT, PA_CSI_DISPATCH);
+    EXPECT(PS_GROUND, "\x1b[<0;1;2M", PS_GROUND,
+            PA_CSI_START, PA_PRIVATE, PA_PARAM_DIGIT, PA_PARAM_NEXT, PA_PARAM_DIGIT,
+            PA_PARAM_NEXT, PA_PARAM_DIGIT, PA_CSI_DISPATCH);
+    EXPECT(PS_GROUND, "\x1b[?69;2$y", PS_GROUND,
+            PA_CSI_START, PA_PRIVATE, PA_PARAM_DIGIT, PA_PARAM_DIGIT, PA_PARAM_NEXT,
+            PA_PARAM_DIGIT, PA_INTERMEDIATE, PA_CSI_DISPATCH);
+
+    /* malformed csi is skipped up to its final byte */
+    EXPECT(PS_GROUND, "\x1b[1$2xa", PS_GROUND,
+            PA_CSI_START, PA_PARAM_DIGIT, PA_INTERMEDIATE, PA_KEY);
+    EXPECT(PS_GROUND, "\x1b[1<2xa", PS_GROUND, PA_CSI_START, PA_PARAM_DIGIT, PA_KEY);
+    EXPECT(PS_GROUND, "\x1b[1" "\x1b" "b", PS_GROUND, PA_CSI_START, PA_PARAM_DIGIT, PA_ALT_KEY);
+
+    /* ss3 and x10 mouse, the latter takes any three bytes */
+    EXPECT(PS_GROUND, "\x1bOP", PS_GROUND, PA_SS3_DISPATCH);
+    EXPECT(PS_GROUND, "\x1b[M \x1b\xff", PS_GROUND,
+            PA_CSI_START, PA_MOUSE_BYTE, PA_MOUSE_BYTE, PA_MOUSE_X10);
+
+    /* bracketed paste, only its exact terminator ends it */
+    EXPECT(PS_PASTE, "\x1b[201~", PS_GROUND, PA_PASTE_END);
+    EXPECT(PS_PASTE, "\x1b[20x", PS_PASTE, PA_PASTE_MISMATCH);
+    EXPECT(PS_PASTE, "\x1b[2\x1b[201~", PS_GROUND, PA_PASTE_MISMATCH, PA_PASTE_END);
+
+    /* ESC restarts a sequence from anywhere but the paste and a mouse report */
+    for (parser_state_t state = PS_GROUND; state < PS_COUNT; ++state)
+    {
+        const bool raw = (state >= PS_MOUSE_1 && state <= PS_MOUSE_3) || state >= PS_PASTE;
+        if (raw) continue;
+        assert(PS_ESCAPE == g_parser_table[state]['\x1b'].next);
+    }
+
+    puts("parser: ok");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,90 @@
+#include "ring.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static int segments(const ring_t *const ring, const size_t from, const size_t size,
+        struct iovec iov[static 2]);
+
+
+void ring_init(ring_t *const ring, const size_t capacity)
+{
+    assert(capacity && 0 == (capacity & (capacity - 1)));
+
+    *ring = (ring_t){ .capacity = capacity };
+    ring->data = malloc(capacity);
+    if (!ring->data)
+    {
+        perror("ring_init");
+        exit(EXIT_FAILURE);
+    }
+}
+
+
+void ring_deinit(ring_t *const ring)
+{
+    free(ring->data);
+    *ring = (ring_t){0};
+}
+
+
+size_t ring_avail_to_read(const ring_t *const ring)
+{
+    return ring->tail - ring->head;
+}
+
+
+size_t ring_avail_to_write(const ring_t *const ring)
+{
+    return ring->capacity - ring_avail_to_read(ring);
+}
+
+
+int ring_free_segments(const ring_t *const ring, struct iovec iov[static 2])
+{
+    return segments(ring, ring->tail, ring_avail_to_write(ring), iov);
+}
+
+
+int ring_data_segments(const ring_t *const ring, struct iovec iov[static 2])
+{
+    return segments(ring, ring->head, ring_avail_to_read(ring), iov);
+}
+
+
+void ring_produce(ring_t *const ring, const size_t size)
+{
+    assert(size <= ring_avail_to_write(ring));
+    ring->tail += size;
+}
+
+
+void ring_consume(ring_t *const ring, const size_t size)
+{
+    assert(size <= ring_avail_to_read(ring));
+    ring->head += size;
+
+    /* rewind an empty ring, so that the next read is a single segment */
+    if (ring->head == ring->tail)
+    {
+        ring->head = ring->tail = 0;
+    }
+}
+
+
+/* Splits `size` bytes starting at position `from` at the end of the storage */
+static int segments(const ring_t *const ring, const size_t from, const size_t size,
+        struct iovec iov[static 2])
+{
+    if (!size) return 0;
+
+    const size_t start = from & (ring->capacity - 1);
+    const size_t first = ring->capacity - start;
+
+    iov[0] = (struct iovec){ .iov_base = ring->data + start, .iov_len = size < first ? size : first };
+    if (size <= first) return 1;
+
+    iov[1] = (struct iovec){ .iov_base = ring->data, .iov_len = size - first };
+    return 2;
+}
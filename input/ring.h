@@ -0,0 +1,36 @@
+#ifndef _RING_H_
+#define _RING_H_
+
+#include <stddef.h>
+#include <sys/uio.h>
+
+/*
+* Byte ring that exposes its free and readable parts as iovec segments,
+* so that readv lands straight in it and the parser scans bytes in place.
+* Capacity is a power of two, positions are free running counters.
+*/
+
+typedef struct
+{
+    unsigned char *data;
+    size_t capacity;
+    size_t head; /* read position */
+    size_t tail; /* write position */
+}
+ring_t;
+
+void ring_init(ring_t *const ring, const size_t capacity);
+void ring_deinit(ring_t *const ring);
+
+size_t ring_avail_to_read(const ring_t *const ring);
+size_t ring_avail_to_write(const ring_t *const ring);
+
+/* Fill `iov` with up to two segments, returns their count, zero when there is none */
+int ring_free_segments(const ring_t *const ring, struct iovec iov[static 2]);
+int ring_data_segments(const ring_t *const ring, struct iovec iov[static 2]);
+
+/* Account for bytes written into free segments / taken from data segments */
+void ring_produce(ring_t *const ring, const size_t size);
+void ring_consume(ring_t *const ring, const size_t size);
+
+#endif/*_RING_H_*/
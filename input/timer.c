@@ -0,0 +1,202 @@
+#include "timer.h"
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+static void arm(const timers_t *const timers);
+static void push(timers_t *const timers, const timer_entry_t entry);
+static void remove_at(timers_t *const timers, size_t at);
+static void sift_up(timer_entry_t heap[], size_t at);
+static void sift_down(timer_entry_t heap[], const size_t count, size_t at);
+static void swap(timer_entry_t *const a, timer_entry_t *const b);
+
+
+void timers_init(timers_t *const timers, const int epfd)
+{
+    *timers = (timers_t){0};
+    timers->fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (-1 == timers->fd)
+    {
+        perror("timerfd_create");
+        exit(EXIT_FAILURE);
+    }
+
+    struct epoll_event ev = {
+        .events = EPOLLIN,
+        .data.fd = timers->fd,
+    };
+    if (-1 == epoll_ctl(epfd, EPOLL_CTL_ADD, timers->fd, &ev))
+    {
+        perror("epoll_ctl: timerfd");
+        exit(EXIT_FAILURE);
+    }
+}
+
+
+void timers_deinit(timers_t *const timers)
+{
+    close(timers->fd); /* also drops it from the epoll set */
+    free(timers->heap);
+    *timers = (timers_t){ .fd = -1 };
+}
+
+
+timer_id_t timers_add(timers_t *const timers, const unsigned int delay, const unsigned int period,
+        timer_callback_t callback, void *const data)
+{
+    if (0 == ++timers->last_id) ++timers->last_id; /* skip zero on wrap */
+
+    push(timers, (timer_entry_t){
+        .deadline = timers_now() + delay,
+        .period = period,
+        .id = timers->last_id,
+        .callback = callback,
+        .data = data,
+    });
+    arm(timers);
+    return timers->last_id;
+}
+
+
+bool timers_cancel(timers_t *const timers, const timer_id_t id)
+{
+    for (size_t i = 0; i < timers->count; ++i)
+    {
+        if (id == timers->heap[i].id)
+        {
+            remove_at(timers, i);
+            arm(timers);
+            return true;
+        }
+    }
+    return false;
+}
+
+
+void timers_expire(timers_t *const timers)
+{
+    uint64_t expirations;
+    (void) read(timers->fd, &expirations, sizeof(expirations)); /* only clears readiness */
+
+    const long long now = timers_now();
+    while (timers->count && timers->heap[0].deadline <= now)
+    {
+        timer_entry_t entry = timers->heap[0];
+        remove_at(timers, 0);
+
+        if (entry.period)
+        {
+            /* skip missed periods instead of firing them in a burst */
+            entry.deadline += entry.period;
+            if (entry.deadline <= now) entry.deadline = now + entry.period;
+            push(timers, entry);
+        }
+
+        /* after the heap is consistent, so that callback may add or cancel timers */
+        entry.callback(entry.data);
+    }
+    arm(timers);
+}
+
+
+long long timers_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+
+/* Sets timerfd to the earliest deadline, disarms it when there are no timers */
+static void arm(const timers_t *const timers)
+{
+    struct itimerspec spec = {0};
+    if (timers->count)
+    {
+        const long long deadline = timers->heap[0].deadline;
+        spec.it_value.tv_sec = deadline / 1000;
+        spec.it_value.tv_nsec = (deadline % 1000) * 1000000;
+        if (0 == spec.it_value.tv_sec && 0 == spec.it_value.tv_nsec)
+        {
+            spec.it_value.tv_nsec = 1; /* zero would disarm it */
+        }
+    }
+    if (-1 == timerfd_settime(timers->fd, TFD_TIMER_ABSTIME, &spec, NULL))
+    {
+        perror("timerfd_settime");
+    }
+}
+
+
+static void push(timers_t *const timers, const timer_entry_t entry)
+{
+    if (timers->count == timers->capacity)
+    {
+        const size_t capacity = timers->capacity ? timers->capacity * 2 : TIMERS_INITIAL_CAP;
+        timer_entry_t *heap = realloc(timers->heap, capacity * sizeof(timer_entry_t));
+        if (!heap)
+        {
+            perror("timers_add");
+            exit(EXIT_FAILURE);
+        }
+        timers->heap = heap;
+        timers->capacity = capacity;
+    }
+    timers->heap[timers->count] = entry;
+    sift_up(timers->heap, timers->count++);
+}
+
+
+static void remove_at(timers_t *const timers, size_t at)
+{
+    timers->heap[at] = timers->heap[--timers->count];
+    if (at < timers->count)
+    {
+        sift_up(timers->heap, at);
+        sift_down(timers->heap, timers->count, at);
+    }
+}
+
+
+static void sift_up(timer_entry_t heap[], size_t at)
+{
+    while (at)
+    {
+        const size_t parent = (at - 1) / 2;
+        if (heap[parent].deadline <= heap[at].deadline) break;
+        swap(&heap[parent], &heap[at]);
+        at = parent;
+    }
+}
+
+
+static void sift_down(timer_entry_t heap[], const size_t count, size_t at)
+{
+    while (true)
+    {
+        const size_t left = 2 * at + 1;
+        const size_t right = left + 1;
+        size_t smallest = at;
+
+        if (left < count && heap[left].deadline < heap[smallest].deadline) smallest = left;
+        if (right < count && heap[right].deadline < heap[smallest].deadline) smallest = right;
+        if (smallest == at) break;
+
+        swap(&heap[smallest], &heap[at]);
+        at = smallest;
+    }
+}
+
+
+static void swap(timer_entry_t *const a, timer_entry_t *const b)
+{
+    const timer_entry_t t = *a;
+    *a = *b;
+    *b = t;
+}
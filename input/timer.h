@@ -0,0 +1,58 @@
+#ifndef _TIMER_H_
+#define _TIMER_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+* One-shot and periodic timers behind a single timerfd.
+* Timers are kept in a binary heap by deadline, timerfd is armed
+* for the earliest one, so the event loop sleeps until it is due.
+*/
+
+#define TIMERS_INITIAL_CAP 8
+
+typedef unsigned int timer_id_t; /* zero is never a valid id */
+
+typedef void (*timer_callback_t)(void *const data);
+
+typedef struct
+{
+    long long deadline; /* monotonic ms */
+    unsigned int period; /* ms, zero for one-shot */
+    timer_id_t id;
+    timer_callback_t callback;
+    void *data;
+}
+timer_entry_t;
+
+typedef struct
+{
+    int fd; /* timerfd, readable when the earliest timer is due */
+    timer_entry_t *heap;
+    size_t count;
+    size_t capacity;
+    timer_id_t last_id;
+}
+timers_t;
+
+/* Creates the timerfd and registers it on `epfd` */
+void timers_init(timers_t *const timers, const int epfd);
+void timers_deinit(timers_t *const timers);
+
+/*
+* Calls `callback` after `delay` ms, then every `period` ms unless it is zero.
+* Returns id to cancel the timer with.
+*/
+timer_id_t timers_add(timers_t *const timers, const unsigned int delay, const unsigned int period,
+        timer_callback_t callback, void *const data);
+
+/* Returns false when timer has already fired (one-shot) or was never there */
+bool timers_cancel(timers_t *const timers, const timer_id_t id);
+
+/* Runs callbacks of due timers, to be called when timerfd is readable */
+void timers_expire(timers_t *const timers);
+
+long long timers_now(void);
+
+#endif/*_TIMER_H_*/
@@ -0,0 +1,100 @@
+#include "utf8.h"
+
+#if defined(__GNUC__) && defined(__SSE2__)
+#   define UTF8_SSE2
+#   include <emmintrin.h>
+#endif
+
+#define ASCII_BLOCK 16
+
+static size_t widen_ascii(const unsigned char *const s, const size_t size, uint32_t out[]);
+static size_t decode_one(const unsigned char *const s, const size_t size, uint32_t *const codepoint);
+
+
+bool utf8_valid(const uint32_t codepoint, const unsigned int length)
+{
+    static const uint32_t min[] = { 0, 0, 0x80, 0x800, 0x10000 };
+    return length <= 4
+        && codepoint >= min[length]
+        && codepoint <= 0x10ffff
+        && (codepoint < 0xd800 || codepoint > 0xdfff);
+}
+
+
+size_t utf8_decode(const char *const string, const size_t size, uint32_t out[])
+{
+    const unsigned char *const s = (const unsigned char*)string;
+    size_t count = 0;
+    size_t i = 0;
+    while (i < size)
+    {
+        const size_t ascii = widen_ascii(&s[i], size - i, &out[count]);
+        i += ascii;
+        count += ascii;
+        if (i == size) break;
+
+        i += decode_one(&s[i], size - i, &out[count++]);
+    }
+    return count;
+}
+
+
+/* Copies leading ASCII run into codepoints, returns its length */
+static size_t widen_ascii(const unsigned char *const s, const size_t size, uint32_t out[])
+{
+    size_t i = 0;
+#ifdef UTF8_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + ASCII_BLOCK <= size; i += ASCII_BLOCK)
+    {
+        const __m128i bytes = _mm_loadu_si128((const __m128i*)&s[i]);
+        if (_mm_movemask_epi8(bytes)) break; /* high bit of some byte is set */
+
+        const __m128i lo = _mm_unpacklo_epi8(bytes, zero);
+        const __m128i hi = _mm_unpackhi_epi8(bytes, zero);
+        _mm_storeu_si128((__m128i*)&out[i + 0],  _mm_unpacklo_epi16(lo, zero));
+        _mm_storeu_si128((__m128i*)&out[i + 4],  _mm_unpackhi_epi16(lo, zero));
+        _mm_storeu_si128((__m128i*)&out[i + 8],  _mm_unpacklo_epi16(hi, zero));
+        _mm_storeu_si128((__m128i*)&out[i + 12], _mm_unpackhi_epi16(hi, zero));
+    }
+#endif
+    for (; i < size && s[i] < 0x80; ++i)
+    {
+        out[i] = s[i];
+    }
+    return i;
+}
+
+
+/* Returns bytes taken, an invalid sequence yields a replacement for its lead byte */
+static size_t decode_one(const unsigned char *const s, const size_t size, uint32_t *const codepoint)
+{
+    unsigned int length;
+    uint32_t value;
+    if (0xc2 <= s[0] && s[0] <= 0xdf)      { length = 2; value = s[0] & 0x1f; }
+    else if (0xe0 <= s[0] && s[0] <= 0xef) { length = 3; value = s[0] & 0x0f; }
+    else if (0xf0 <= s[0] && s[0] <= 0xf4) { length = 4; value = s[0] & 0x07; }
+    else
+    {
+        *codepoint = UTF8_REPLACEMENT;
+        return 1;
+    }
+
+    if (length > size)
+    {
+        *codepoint = UTF8_REPLACEMENT;
+        return 1;
+    }
+    for (unsigned int i = 1; i < length; ++i)
+    {
+        if ((s[i] & 0xc0) != 0x80)
+        {
+            *codepoint = UTF8_REPLACEMENT;
+            return 1;
+        }
+        value = (value << 6) | (s[i] & 0x3f);
+    }
+
+    *codepoint = utf8_valid(value, length) ? value : UTF8_REPLACEMENT;
+    return length;
+}
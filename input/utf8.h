@@ -0,0 +1,26 @@
+#ifndef _UTF8_H_
+#define _UTF8_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+* UTF-8 decoding of complete buffers such as pastes.
+* Keystrokes are decoded incrementally by the input parser,
+* which shares the validity rules from here.
+*/
+
+#define UTF8_REPLACEMENT 0xfffd /* stands for every invalid sequence */
+
+/* Rejects overlong forms, surrogates and values past U+10FFFF */
+bool utf8_valid(const uint32_t codepoint, const unsigned int length);
+
+/*
+* Decodes `size` bytes into `out`, that must hold `size` codepoints.
+* Returns amount of codepoints decoded.
+* ASCII runs are validated and widened 16 bytes at a time.
+*/
+size_t utf8_decode(const char *const string, const size_t size, uint32_t out[]);
+
+#endif/*_UTF8_H_*/
@@ -0,0 +1,135 @@
+#include "utf8.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+* Every scalar value is encoded and decoded back, malformed input
+* is checked against the replacements it has to produce.
+*/
+
+#define R UTF8_REPLACEMENT
+#define MAX_CODEPOINTS 64
+
+
+static size_t encode(const uint32_t codepoint, char out[])
+{
+    if (codepoint < 0x80)
+    {
+        out[0] = codepoint;
+        return 1;
+    }
+    if (codepoint < 0x800)
+    {
+        out[0] = 0xc0 | (codepoint >> 6);
+        out[1] = 0x80 | (codepoint & 0x3f);
+        return 2;
+    }
+    if (codepoint < 0x10000)
+    {
+        out[0] = 0xe0 | (codepoint >> 12);
+        out[1] = 0x80 | ((codepoint >> 6) & 0x3f);
+        out[2] = 0x80 | (codepoint & 0x3f);
+        return 3;
+    }
+    out[0] = 0xf0 | (codepoint >> 18);
+    out[1] = 0x80 | ((codepoint >> 12) & 0x3f);
+    out[2] = 0x80 | ((codepoint >> 6) & 0x3f);
+    out[3] = 0x80 | (codepoint & 0x3f);
+    return 4;
+}
+
+
+static void expect(const char *const bytes, const size_t size,
+        const uint32_t expected[], const size_t count)
+{
+    uint32_t out[MAX_CODEPOINTS];
+    assert(size <= MAX_CODEPOINTS);
+
+    const size_t decoded = utf8_decode(bytes, size, out);
+    assert(count == decoded);
+    assert(0 == memcmp(expected, out, count * sizeof(uint32_t)));
+}
+
+#define EXPECT(bytes, ...) expect((bytes), sizeof(bytes) - 1, (const uint32_t[]){ __VA_ARGS__ }, \
+        sizeof((const uint32_t[]){ __VA_ARGS__ }) / sizeof(uint32_t))
+
+
+static void check_round_trip(void)
+{
+    const size_t scalars = 0x110000 - 0x800; /* without surrogates */
+    char *bytes = malloc(scalars * 4);
+    uint32_t *out = malloc(scalars * 4 * sizeof(uint32_t));
+    assert(bytes && out);
+
+    size_t size = 0;
+    for (uint32_t cp = 0; cp < 0x110000; ++cp)
+    {
+        if (0xd800 == cp) cp = 0xe000;
+        size += encode(cp, &bytes[size]);
+    }
+
+    assert(scalars == utf8_decode(bytes, size, out));
+    size_t i = 0;
+    for (uint32_t cp = 0; cp < 0x110000; ++cp, ++i)
+    {
+        if (0xd800 == cp) cp = 0xe000;
+        assert(cp == out[i]);
+    }
+    free(bytes);
+    free(out);
+}
+
+
+/* ASCII runs are widened in blocks, a multibyte character may end each of them */
+static void check_ascii_runs(void)
+{
+    char bytes[MAX_CODEPOINTS];
+    uint32_t expected[MAX_CODEPOINTS];
+    for (size_t run = 0; run + 2 <= MAX_CODEPOINTS; ++run)
+    {
+        for (size_t i = 0; i < run; ++i)
+        {
+            bytes[i] = 'a' + i % 26;
+            expected[i] = bytes[i];
+        }
+        memcpy(&bytes[run], "\xc3\xa9", 2);
+        expected[run] = 0xe9;
+
+        expect(bytes, run, expected, run);
+        expect(bytes, run + 2, expected, run + 1);
+    }
+}
+
+
+int main(void)
+{
+    expect("", 0, (const uint32_t[]){ 0 }, 0);
+    EXPECT("a\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80", 'a', 0xe9, 0x20ac, 0x1f600);
+
+    /* stray continuation and bytes that never start a character */
+    EXPECT("\x80", R);
+    EXPECT("\xbf" "a", R, 'a');
+    EXPECT("\xc0\xaf", R, R);
+    EXPECT("\xf5\x80", R, R);
+    EXPECT("\xff", R);
+
+    /* broken character, the rest is decoded on its own */
+    EXPECT("\xe2\x82", R, R);
+    EXPECT("\xe2" "a", R, 'a');
+    EXPECT("\xf0\x9f\x98", R, R, R);
+
+    /* well formed but not allowed: overlong, surrogate, past U+10FFFF */
+    EXPECT("\xe0\x80\xaf", R);
+    EXPECT("\xf0\x80\x80\xaf", R);
+    EXPECT("\xed\xa0\x80", R);
+    EXPECT("\xf4\x90\x80\x80", R);
+
+    check_ascii_runs();
+    check_round_trip();
+
+    puts("utf8: ok");
+    return EXIT_SUCCESS;
+}
@@ -15,24 +15,36 @@
 #include <locale.h>
 #include <stddef.h>
 #include <stdio.h>
+#include <string.h>
+#include <unistd.h>
 
 size_t g_array [] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
 
+#define TIFC_DEMO_ROWS 10000000 /* generated rows of the list view */
+
 static int tifc_event_loop(void);
-static tifc_t tifc_init(void);
+static void tifc_init(tifc_t *const tifc);
 static void tifc_create_ui_layout(tifc_t *const tifc);
 
 static void make_view_panel(tifc_t *const tifc);
 static void make_composite_panel(tifc_t *const tifc);
 
+static void tifc_on_resize(input_t *const input, const int fd, ring_t *const queue,
+        const bool closed, void *const data);
 static void tifc_render(tifc_t *const tifc);
+static int tifc_frame_timeout(tifc_t *const tifc, long long *const next_frame);
 static size_t g_array_amount(const void *const source);
+static size_t g_array_get_range(void *const source, const size_t first, const size_t count, void *const items);
+static void rows_fetch(void *const store, const size_t first, const size_t count, void *const items);
+static void rows_loaded(void *const data);
 
-static void size_t_array_render(display_t *const display,
-        const interior_area_t *const area,
-        const void *const source, const size_t limit,
+static void size_t_item_render(display_t *const display,
+        const interior_area_t *const area, const void *const item,
         const size_t index, const bool hovered);
 
+static void row_render(display_t *const display, const interior_area_t *const area,
+        const void *const item, const size_t index, const bool hovered, void *const store);
+
 static void default_render(display_t *const display, const interior_area_t *const area,
         const void *const source, const size_t limit, const size_t index);
 
@@ -50,23 +62,21 @@ int main(void)
 
 static int tifc_event_loop(void)
 {
-    tifc_t tifc = tifc_init();
-    resize_hook_with_data_t resize_hook = {
-        .data = &tifc.ui,
-        .hook = ui_resize_hook,
-    };
+    tifc_t tifc;
+    tifc_init(&tifc);
     display_hide_cursor();
-    display_set_resize_handler(&tifc.display, resize_hook);
+    display_erase();
     tifc_create_ui_layout(&tifc);
 
     int exit_status = 0;
+    long long next_frame = 0;
 
     while (1)
     {
         // input_display_overlay(&tifc.input, (disp_pos_t){.x = 0, .y = 3});
-        tifc_render(&tifc);
+        const int timeout = tifc_frame_timeout(&tifc, &next_frame);
         input_hooks_t *hooks = &tifc.ui.hooks;
-        exit_status = input_handle_events(&tifc.input, hooks, &tifc.ui);
+        exit_status = input_wait_events(&tifc.input, hooks, &tifc.ui, timeout);
         if (0 != exit_status || tifc.ui.exit_requested)
         {
             display_erase();
@@ -82,16 +92,22 @@ static int tifc_event_loop(void)
 }
 
 
-static tifc_t tifc_init(void)
+static void tifc_init(tifc_t *const tifc)
 {
     display_enter_alternate_screen();
     setlocale(LC_ALL, "");
     input_enable_mouse();
-    tifc_t tifc = {
-        .input = input_init(),
-        .ui = ui_init(),
-    };
-    return tifc;
+    tifc->input = input_init();
+    tifc->ui = ui_init(&tifc->input);
+    display_init(&tifc->display);
+    tifc->fps = TIFC_DEFAULT_FPS;
+
+    tifc->resize_pending = false;
+    tifc->resize_fd = display_open_resize_fd();
+    if (INPUT_SUCCESS != input_watch_fd(&tifc->input, tifc->resize_fd, 0, tifc_on_resize, tifc))
+    {
+        exit(EXIT_FAILURE);
+    }
 }
 
 
@@ -108,45 +124,22 @@ static void tifc_create_ui_layout(tifc_t *const tifc)
 
 static void make_view_panel(tifc_t *const tifc)
 {
+    tifc->rows = paged_source_create(&tifc->input, &(paged_source_opts_t){
+        .amount = TIFC_DEMO_ROWS,
+        .item_size = sizeof(size_t),
+        .fetch = rows_fetch,
+        .render = row_render,
+        .loaded = rows_loaded,
+        .loaded_data = &tifc->ui,
+    });
+
     view_opts_t view = {
         .interior = {
             .impl = view_interior_get_impl(),
-            .layout = {
-                .columns = 1,
-                .columns_def = (counted_layout_def_t[]){
-                    {
-                        .amount = 1,
-                        .layout = {
-                            .size = 100,
-                            .size_method = LAYOUT_SIZE_RELATIVE
-                        }
-                    },
-                },
-                .rows = 11,
-                .rows_def = (counted_layout_def_t[]){
-                    {.amount = 11, .layout = { .size = 3}},
-                },
-                .areas = 11,
-                .areas_def = (interior_area_def_t[]){
-                    {{0, 0}, {0, 0}},
-                    {{0, 0}, {1, 1}},
-                    {{0, 0}, {2, 2}},
-                    {{0, 0}, {3, 3}},
-                    {{0, 0}, {4, 4}},
-                    {{0, 0}, {5, 5}},
-                    {{0, 0}, {6, 6}},
-                    {{0, 0}, {7, 7}},
-                    {{0, 0}, {8, 8}},
-                    {{0, 0}, {9, 9}},
-                    {{0, 0}, {10, 10}},
-                }
-            },
-        },
-        .source = {
-            .data = g_array,
-            .get_amount = g_array_amount,
-            .render = size_t_array_render,
+            .layout = VIEW_LIST_LAYOUT,
         },
+        .source = paged_source_data_source(tifc->rows),
+        .mode = VIEW_MODE_LIST,
     };
 
     panel_opts_t *panel = &(panel_opts_t){
@@ -200,7 +193,9 @@ static void make_composite_panel(tifc_t *const tifc)
         .source = {
             .data = g_array,
             .get_amount = g_array_amount,
-            .render = size_t_array_render,
+            .get_range = g_array_get_range,
+            .render_item = size_t_item_render,
+            .item_size = sizeof(size_t),
         },
     };
     button_opts_t btn = {
@@ -348,27 +343,116 @@ static size_t g_array_amount(const void *const source)
 }
 
 
+static size_t g_array_get_range(void *const source, const size_t first, const size_t count, void *const items)
+{
+    const size_t amount = g_array_amount(source);
+    if (first >= amount) return 0;
+
+    const size_t available = (amount - first < count) ? amount - first : count;
+    memcpy(items, (const size_t*)source + first, available * sizeof(size_t));
+    return available;
+}
+
+
+/* Runs on the worker of the paged source */
+static void rows_fetch(void *const store, const size_t first, const size_t count, void *const items)
+{
+    UNUSED(store);
+    size_t *rows = items;
+
+#ifdef TIFC_DEMO_LATENCY
+    usleep(TIFC_DEMO_LATENCY); /* -DTIFC_DEMO_LATENCY=<us> pretends the rows come from a remote store */
+#endif
+    for (size_t i = 0; i < count; ++i)
+    {
+        rows[i] = first + i;
+    }
+}
+
+
+/* View is invalidated by the source, frame has to be requested */
+static void rows_loaded(void *const data)
+{
+    ui_invalidate(data);
+}
+
+
+/*
+* Renders when something was invalidated and the frame interval has passed.
+* Returns how long input may be waited for: until the next frame is due,
+* or without a limit when there is nothing to draw.
+*/
+static int tifc_frame_timeout(tifc_t *const tifc, long long *const next_frame)
+{
+    if (!tifc->ui.invalidated)
+    {
+        return -1;
+    }
+
+    const long long now = timers_now();
+    if (now < *next_frame)
+    {
+        return *next_frame - now;
+    }
+
+    /* fps of zero leaves rendering uncapped */
+    const int interval = tifc->fps ? (int)(1000 / tifc->fps) : 0;
+    tifc_render(tifc);
+    *next_frame = now + interval;
+
+    /* something could be invalidated while rendering */
+    return tifc->ui.invalidated ? interval : -1;
+}
+
+
+/*
+* A burst of SIGWINCH just marks resize as pending,
+* the frame applies the final size once.
+*/
+static void tifc_on_resize(input_t *const input, const int fd, ring_t *const queue,
+        const bool closed, void *const data)
+{
+    UNUSED(input, fd, closed);
+    tifc_t *const tifc = data;
+
+    ring_consume(queue, ring_avail_to_read(queue)); /* content of siginfo is not needed */
+    tifc->resize_pending = true;
+    ui_invalidate(&tifc->ui);
+}
+
+
 static void tifc_render(tifc_t *const tifc)
 {
-    display_clear(&tifc->display);
+    if (tifc->resize_pending)
+    {
+        tifc->resize_pending = false;
+        if (display_sync_size(&tifc->display))
+        {
+            ui_recalculate(&tifc->ui, &tifc->display);
+        }
+    }
+
+    /* the terminal answers to the query some time after start */
+    display_set_lr_margins(&tifc->display, tifc->input.lr_margins);
+
+    tifc->ui.invalidated = false;
     ui_render(&tifc->ui, &tifc->display);
     display_render(&tifc->display);
 }
 
 
 
-static void size_t_array_render(display_t *const display,
-        const interior_area_t *const area,
-        const void *const source, const size_t limit,
+static void size_t_item_render(display_t *const display,
+        const interior_area_t *const area, const void *const item,
         const size_t index, const bool hovered)
 {
-    const size_t *source_ = source;
-    char buf[18];
-    size_t size = sprintf(buf, "%zu", source_[index]);
+    UNUSED(index);
     border_set_t border = {._ = L"╭╮╯╰┆┄"};
 
-    if (index < limit)
+    if (item)
     {
+        char buf[21];
+        const size_t size = sprintf(buf, "%zu", *(const size_t*)item);
         style_t style = BORDER_STYLE_1;
         if (hovered)
         {
@@ -385,6 +469,25 @@ static void size_t_array_render(display_t *const display,
 }
 
 
+static void row_render(display_t *const display, const interior_area_t *const area,
+        const void *const item, const size_t index, const bool hovered, void *const store)
+{
+    UNUSED(store);
+    char buf[32];
+    const size_t size = item
+        ? sprintf(buf, "row %zu", *(const size_t*)item)
+        : sprintf(buf, "%zu ...", index);
+
+    style_t style = {.seq = item ? ESC"[37m" : ESC"[90m"};
+    if (hovered)
+    {
+        style = (style_t){.seq = ESC"[37;100m"};
+        display_fill_area(display, style, area->area);
+    }
+    display_draw_string(display, size, buf, area->area.first, style);
+}
+
+
 static void default_render(display_t *const display, const interior_area_t *const area,
         const void *const source, const size_t limit, const size_t index)
 {
@@ -412,8 +515,11 @@ static void inp_action(void *const data)
 static void tifc_deinit(tifc_t *const tifc)
 {
     input_disable_mouse();
+    paged_source_destroy(tifc->rows);
     input_deinit(&tifc->input);
+    close(tifc->resize_fd);
     ui_deinit(&tifc->ui);
+    display_deinit(&tifc->display);
     display_leave_alternate_screen();
 }
 
@@ -3,13 +3,20 @@
 
 #include "display.h"
 #include "input.h"
+#include "paged_source.h"
 #include "ui.h"
 
+#define TIFC_DEFAULT_FPS 60
+
 typedef struct tifc
 {
     display_t    display;
     input_t      input;
     ui_t         ui;
+    unsigned int fps; /* renders per second at most, 0 - uncapped */
+    int          resize_fd; /* signalfd for SIGWINCH */
+    bool         resize_pending; /* applied once by the next frame */
+    paged_source_t *rows;        /* of the list view, loaded in background */
 }
 tifc_t;
 
@@ -59,6 +59,7 @@ interior_interface_t button_interior_get_impl(void)
         .lost_focus  = interior_focus_stub,
         .scroll      = interior_scroll_stub,
         .keystroke   = interior_keystroke_stub,
+        .paste       = interior_paste_stub,
     };
 }
 
@@ -116,6 +117,7 @@ static void button_press(interior_t *const base, const disp_pos_t pos, const int
     UNUSED(pos);
     button_t *interior = (button_t*)base;
     interior->button.pressed = true;
+    interior_invalidate(base);
     if (BUTTON_ON_PRESS == interior->button.action.when)
     {
         action_perform(&interior->button.action);
@@ -129,6 +131,7 @@ static void button_release(interior_t *const base, const disp_pos_t pos, const i
     UNUSED(pos);
     button_t *interior = (button_t*)base;
     interior->button.pressed = false;
+    interior_invalidate(base);
     if (BUTTON_ON_RELEASE == interior->button.action.when)
     {
         action_perform(&interior->button.action);
@@ -153,7 +156,11 @@ static void button_leave(interior_t *const base, const disp_pos_t pos)
 {
     button_t *interior = (button_t*)base;
     UNUSED(pos);
-    interior->button.pressed = false;
+    if (interior->button.pressed)
+    {
+        interior->button.pressed = false;
+        interior_invalidate(base);
+    }
 }
 
 
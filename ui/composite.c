@@ -38,6 +38,7 @@ static void composite_scroll(interior_t *const base, const disp_pos_t pos, const
 static void composite_press(interior_t *const base, const disp_pos_t pos, const int btn);
 static void composite_release(interior_t *const base, const disp_pos_t pos, const int btn);
 static void composite_keystroke(interior_t *const interior, const keystroke_event_t *const event);
+static void composite_paste(interior_t *const interior, const paste_event_t *const event);
 
 
 interior_interface_t composite_interior_get_impl(void)
@@ -55,6 +56,7 @@ interior_interface_t composite_interior_get_impl(void)
         .press = composite_press,
         .release = composite_release,
         .keystroke = composite_keystroke,
+        .paste = composite_paste,
 
         /* ignored events: */
         .recv_focus  = interior_focus_stub,
@@ -83,6 +85,7 @@ static void composite_init(interior_t *const base, void *opts, Arena *const aren
         interior_opts_t *comp_opts = composite_opts->component_defs[ci].opts;
         interior_t *component = interior_alloc(comp_opts, arena);
         interior_init(component, comp_opts, arena);
+        component->parent = base; /* its changes are rendered through the composite */
 
         sparse_status_t status = sparse_insert(&interior->composite.components,
                 composite_opts->component_defs[ci].area_idx,
@@ -145,9 +148,13 @@ static void composite_render(const interior_t *base, display_t *const display)
         if (interior_area_is_visible(area))
         {
             interior_t **comp = sparse_get(interior->composite.components, ai);
-            if (comp)
+            const disp_area_t dirty = disp_area_intersection(area->area, base->dirty);
+            if (comp && !IS_INVALID_AREA(&dirty))
             {
+                /* part of the panel that is cleared includes this one */
+                interior_invalidate_area(*comp, dirty);
                 interior_render(*comp, display); // TODO hovered?
+                interior_validate(*comp);
             }
         }
     }
@@ -176,7 +183,10 @@ static void composite_hover(interior_t *const base, const disp_pos_t pos)
         interior_t *cur_hovered = *comp;
         if (last_hovered != *comp)
         {
-            if (last_hovered) { interior_leave(last_hovered, pos); }
+            if (last_hovered)
+            {
+                interior_leave(last_hovered, pos);
+            }
             if (cur_hovered) { interior_enter(cur_hovered, pos); }
         }
         else {
@@ -273,3 +283,14 @@ static void composite_keystroke(interior_t *const base, const keystroke_event_t
         interior_keystroke(interior->composite.last_hovered, event);
     }
 }
+
+
+static void composite_paste(interior_t *const base, const paste_event_t *const event)
+{
+    composite_t *interior = (composite_t*)base;
+
+    if (interior->composite.last_hovered)
+    {
+        interior_paste(interior->composite.last_hovered, event);
+    }
+}
@@ -18,6 +18,8 @@ void interior_init(interior_t *const interior, const interior_opts_t *const opts
 
     *interior = (interior_t){
         .impl = opts->impl,
+        .area = INVALID_AREA,
+        .dirty = INVALID_AREA,
     };
 
     interior_layout_init(&interior->layout, &opts->layout);
@@ -28,6 +30,7 @@ void interior_init(interior_t *const interior, const interior_opts_t *const opts
 void interior_deinit(interior_t *const interior)
 {
     assert(interior);
+    keymap_deinit(&interior->keymap);
     interior_layout_deinit(&interior->layout);
     interior->impl.deinit(interior);
 }
@@ -37,8 +40,10 @@ void interior_recalculate(interior_t *interior, disp_area_t *const panel_area)
 {
     assert(interior);
 
+    interior->area = *panel_area;
     interior_layout_recalculate(&interior->layout, panel_area);
     interior->impl.recalculate(interior, panel_area);
+    interior_invalidate(interior);
 }
 
 
@@ -99,6 +104,13 @@ void interior_keystroke(interior_t *const interior, const keystroke_event_t *con
 }
 
 
+void interior_paste(interior_t *const interior, const paste_event_t *const event)
+{
+    assert(interior);
+    interior->impl.paste(interior, event);
+}
+
+
 void interior_recv_focus(interior_t *const interior)
 {
     UNUSED(interior);
@@ -113,12 +125,51 @@ void interior_lost_focus(interior_t *const interior)
 }
 
 
+void interior_invalidate(interior_t *const interior)
+{
+    assert(interior);
+    interior_invalidate_area(interior, interior->area);
+}
+
+
+void interior_invalidate_area(interior_t *const interior, const disp_area_t area)
+{
+    assert(interior);
+    const disp_area_t clipped = disp_area_intersection(area, interior->area);
+    interior->dirty = disp_area_union(interior->dirty, clipped);
+    if (interior->parent)
+    {
+        interior_invalidate_area(interior->parent, clipped);
+    }
+}
+
+
+bool interior_is_dirty(const interior_t *const interior)
+{
+    assert(interior);
+    return !IS_INVALID_AREA(&interior->dirty);
+}
+
+
+void interior_validate(interior_t *const interior)
+{
+    assert(interior);
+    interior->dirty = INVALID_AREA;
+}
+
+
 void interior_keystroke_stub(interior_t *const interior, const keystroke_event_t *const event)
 {
     UNUSED(interior, event);
 }
 
 
+void interior_paste_stub(interior_t *const interior, const paste_event_t *const event)
+{
+    UNUSED(interior, event);
+}
+
+
 void interior_scroll_stub(interior_t *const interior, const disp_pos_t pos, const int direction)
 {
     UNUSED(interior, pos, direction);
@@ -5,6 +5,7 @@
 #include "display.h"
 #include "input.h"
 #include "interior_layout.h"
+#include "keymap.h"
 #include "utils.h"
 
 /*
@@ -29,6 +30,7 @@ typedef struct
     void (*press) (interior_t *const interior, const disp_pos_t pos, const int btn);
     void (*release) (interior_t *const interior, const disp_pos_t pos, const int btn);
     void (*keystroke) (interior_t *const interior, const keystroke_event_t *const event);
+    void (*paste) (interior_t *const interior, const paste_event_t *const event);
     /* ... */
 }
 interior_interface_t;
@@ -46,6 +48,10 @@ struct interior
 {
     interior_interface_t impl;
     interior_layout_t    layout;
+    keymap_t             keymap; /* bindings active while the panel has focus */
+    disp_area_t          area;   /* given on last recalculate */
+    disp_area_t          dirty;  /* bounding box of what has to be rendered again */
+    interior_t          *parent; /* composite it is a component of, if any */
 };
 
 
@@ -61,13 +67,25 @@ void interior_scroll(interior_t *const interior, const disp_pos_t pos, const int
 void interior_press(interior_t *const interior, const disp_pos_t pos, const int btn);
 void interior_release(interior_t *const interior, const disp_pos_t pos, const int btn);
 void interior_keystroke(interior_t *const interior, const keystroke_event_t *const event);
+void interior_paste(interior_t *const interior, const paste_event_t *const event);
 void interior_recv_focus(interior_t *const interior);
 void interior_lost_focus(interior_t *const interior);
 
+/*
+* Interiors invalidate what their event handlers changed,
+* only dirty ones are rendered, render may skip parts outside `dirty`.
+* A component passes what it invalidates up to its parent, so the panel learns of it.
+*/
+void interior_invalidate(interior_t *const interior);
+void interior_invalidate_area(interior_t *const interior, const disp_area_t area);
+bool interior_is_dirty(const interior_t *const interior);
+void interior_validate(interior_t *const interior); /* after it is rendered */
+
 /* For ignoring key type events */
 void interior_scroll_stub(interior_t *const interior, const disp_pos_t pos, const int direction);
 void interior_press_release_stub(interior_t *const interior, const disp_pos_t pos, const int btn);
 void interior_keystroke_stub(interior_t *const interior, const keystroke_event_t *const event);
+void interior_paste_stub(interior_t *const interior, const paste_event_t *const event);
 void interior_focus_stub(interior_t *const interior);
 
 #endif/*_INTERIOR_H_*/
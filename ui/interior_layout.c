@@ -15,6 +15,8 @@ static void calculate_spans(size_t start_offset, size_t length,
 
 static void calc_areas(dynarr_t *const areas, span_t columns[], span_t rows[]);
 static int valid_area_count(const void *const element, void *const param);
+static void map_owners(owner_map_t *const owners, const dynarr_t *const areas,
+        const disp_area_t *const panel_area);
 
 
 void interior_layout_init(interior_layout_t *const layout,
@@ -64,6 +66,7 @@ void interior_layout_deinit(interior_layout_t *const layout)
     dynarr_destroy(layout->layout);
     dynarr_destroy(layout->spans);
     dynarr_destroy(layout->areas);
+    owner_map_deinit(&layout->owners);
 }
 
 
@@ -128,6 +131,8 @@ void interior_layout_recalculate(interior_layout_t *const layout,
     calc_areas(layout->areas,
         dynarr_get(layout->spans, 0),
         dynarr_get(layout->spans, layout->columns));
+
+    map_owners(&layout->owners, layout->areas, panel_area);
 }
 
 
@@ -141,35 +146,14 @@ size_t interior_layout_count_valid_areas(const interior_layout_t * const layout)
 
 interior_area_t *interior_layout_peek_area(const interior_layout_t *const layout, const disp_pos_t pos)
 {
-    const size_t areas_amount = dynarr_size(layout->areas);
-    for (size_t ai = 0; ai < areas_amount; ++ai)
-    {
-        interior_area_t *area = dynarr_get(layout->areas, ai);
-
-        if (pos.x >= area->area.first.x && pos.x <= area->area.second.x
-          && pos.y >= area->area.first.y && pos.y <= area->area.second.y)
-        {
-            return area;
-        }
-    }
-    return NULL;
+    const ssize_t index = interior_layout_peek_area_index(layout, pos);
+    return (index >= 0) ? dynarr_get(layout->areas, index) : NULL;
 }
 
 
 ssize_t interior_layout_peek_area_index(const interior_layout_t *const layout, const disp_pos_t pos)
 {
-    const size_t areas_amount = dynarr_size(layout->areas);
-    for (size_t ai = 0; ai < areas_amount; ++ai)
-    {
-        interior_area_t *area = dynarr_get(layout->areas, ai);
-
-        if (pos.x >= area->area.first.x && pos.x <= area->area.second.x
-          && pos.y >= area->area.first.y && pos.y <= area->area.second.y)
-        {
-            return ai;
-        }
-    }
-    return -1;
+    return (ssize_t) owner_map_get(&layout->owners, pos) - 1;
 }
 
 
@@ -303,3 +287,22 @@ static int valid_area_count(const void *const element, void *const param)
 
     return 0;
 }
+
+
+/*
+* 'interior_layout_recalculate' helper
+* first area wins where areas overlap, so it is mapped last
+*/
+static void map_owners(owner_map_t *const owners, const dynarr_t *const areas,
+        const disp_area_t *const panel_area)
+{
+    const size_t areas_amount = dynarr_size(areas);
+    assert(areas_amount < (owner_id_t) -1);
+
+    owner_map_reset(owners, panel_area);
+    for (size_t ai = areas_amount; ai > 0; --ai)
+    {
+        const interior_area_t *area = dynarr_get(areas, ai - 1);
+        owner_map_fill(owners, &area->area, ai);
+    }
+}
@@ -4,6 +4,7 @@
 #include "display_types.h"
 #include "dynarr.h"
 #include "layout.h"
+#include "owner_map.h"
 
 #include <stdint.h>
 
@@ -39,6 +40,9 @@ typedef struct interior_layout
     uint16_t rows;
 
     padding_t padding;
+
+    /* area index + 1 for each cell of the panel, rebuilt on recalculate */
+    owner_map_t owners;
 }
 interior_layout_t;
 
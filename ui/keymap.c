@@ -0,0 +1,200 @@
+#include "keymap.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static keymap_binding_t *find_slot(const keymap_t *const keymap, const keymap_key_t key);
+static keymap_binding_t *insert(keymap_t *const keymap, const keymap_key_t key);
+static void grow(keymap_t *const keymap);
+static size_t hash_key(const keymap_key_t key, const size_t capacity);
+static const keymap_t *resolve(const keymap_chord_t *const chord,
+        const keymap_t *const scopes[], const size_t count);
+static keymap_result_t run(const keymap_binding_t *const binding, keymap_chord_t *const pending,
+        const keystroke_event_t *const event, void *const param);
+
+
+void keymap_deinit(keymap_t *const keymap)
+{
+    for (size_t i = 0; i < keymap->capacity; ++i)
+    {
+        keymap_t *chord = keymap->slots[i].chord;
+        if (chord)
+        {
+            keymap_deinit(chord);
+            free(chord);
+        }
+    }
+    free(keymap->slots);
+    *keymap = (keymap_t){0};
+}
+
+
+void keymap_bind(keymap_t *const keymap, const keymap_key_t keys[], const size_t length,
+        keymap_action_t action, void *const data)
+{
+    assert(length && length <= KEYMAP_CHORD_MAX);
+    assert(action);
+
+    keymap_t *level = keymap;
+    for (size_t k = 0; k + 1 < length; ++k)
+    {
+        keymap_binding_t *prefix = insert(level, keys[k]);
+        prefix->action = NULL;
+        if (!prefix->chord)
+        {
+            prefix->chord = calloc(1, sizeof(keymap_t));
+            if (!prefix->chord)
+            {
+                perror("keymap_bind");
+                exit(EXIT_FAILURE);
+            }
+        }
+        level = prefix->chord;
+    }
+
+    keymap_binding_t *binding = insert(level, keys[length - 1]);
+    if (binding->chord)
+    {
+        keymap_deinit(binding->chord);
+        free(binding->chord);
+        binding->chord = NULL;
+    }
+    binding->action = action;
+    binding->data = data;
+}
+
+
+const keymap_binding_t *keymap_lookup(const keymap_t *const keymap, const keymap_key_t key)
+{
+    if (!keymap->count) return NULL;
+
+    const keymap_binding_t *slot = find_slot(keymap, key);
+    return slot->bound ? slot : NULL;
+}
+
+
+keymap_result_t keymap_dispatch(keymap_chord_t *const pending,
+        const keymap_t *const scopes[], const size_t count,
+        const keystroke_event_t *const event, void *const param)
+{
+    const keymap_key_t key = KEYMAP_KEY(event->code, event->modifier);
+
+    if (pending->length)
+    {
+        const keymap_t *level = resolve(pending, scopes, count);
+        const keymap_binding_t *binding = level ? keymap_lookup(level, key) : NULL;
+        if (binding && binding->chord)
+        {
+            pending->keys[pending->length++] = key;
+            return KEYMAP_PENDING;
+        }
+        pending->length = 0;
+        return binding ? run(binding, pending, event, param) : KEYMAP_HANDLED;
+    }
+
+    for (size_t s = 0; s < count; ++s)
+    {
+        if (!scopes[s]) continue;
+
+        const keymap_binding_t *binding = keymap_lookup(scopes[s], key);
+        if (binding) return run(binding, pending, event, param);
+    }
+    return KEYMAP_UNBOUND;
+}
+
+
+/*
+* Keymap the chord leads to, from the first scope that binds its first key,
+* NULL when some key of it is no longer a prefix.
+*/
+static const keymap_t *resolve(const keymap_chord_t *const chord,
+        const keymap_t *const scopes[], const size_t count)
+{
+    const keymap_binding_t *binding = NULL;
+    for (size_t s = 0; s < count && !binding; ++s)
+    {
+        if (scopes[s]) binding = keymap_lookup(scopes[s], chord->keys[0]);
+    }
+
+    for (size_t k = 1; binding && binding->chord && k < chord->length; ++k)
+    {
+        binding = keymap_lookup(binding->chord, chord->keys[k]);
+    }
+    return (binding && binding->chord) ? binding->chord : NULL;
+}
+
+
+static keymap_result_t run(const keymap_binding_t *const binding, keymap_chord_t *const pending,
+        const keystroke_event_t *const event, void *const param)
+{
+    if (binding->chord)
+    {
+        pending->keys[0] = KEYMAP_KEY(event->code, event->modifier);
+        pending->length = 1;
+        return KEYMAP_PENDING;
+    }
+    binding->action(event, binding->data, param);
+    return KEYMAP_HANDLED;
+}
+
+
+/* Slot of the key or the empty one where it belongs */
+static keymap_binding_t *find_slot(const keymap_t *const keymap, const keymap_key_t key)
+{
+    const size_t mask = keymap->capacity - 1;
+    size_t i = hash_key(key, keymap->capacity);
+    while (keymap->slots[i].bound && keymap->slots[i].key != key)
+    {
+        i = (i + 1) & mask;
+    }
+    return &keymap->slots[i];
+}
+
+
+static keymap_binding_t *insert(keymap_t *const keymap, const keymap_key_t key)
+{
+    /* keep load under 3/4, so that probing stays short */
+    if (4 * (keymap->count + 1) > 3 * keymap->capacity)
+    {
+        grow(keymap);
+    }
+
+    keymap_binding_t *slot = find_slot(keymap, key);
+    if (!slot->bound)
+    {
+        *slot = (keymap_binding_t){ .key = key, .bound = true };
+        ++keymap->count;
+    }
+    return slot;
+}
+
+
+static void grow(keymap_t *const keymap)
+{
+    const keymap_t old = *keymap;
+    keymap->capacity = old.capacity ? old.capacity * 2 : KEYMAP_INITIAL_CAP;
+    keymap->slots = calloc(keymap->capacity, sizeof(keymap_binding_t));
+    if (!keymap->slots)
+    {
+        perror("keymap grow");
+        exit(EXIT_FAILURE);
+    }
+
+    for (size_t i = 0; i < old.capacity; ++i)
+    {
+        if (old.slots[i].bound)
+        {
+            *find_slot(keymap, old.slots[i].key) = old.slots[i];
+        }
+    }
+    free(old.slots);
+}
+
+
+/* Fibonacci hashing, capacity is a power of two */
+static size_t hash_key(const keymap_key_t key, const size_t capacity)
+{
+    const uint32_t product = key * UINT32_C(2654435769);
+    return (product >> 16) & (capacity - 1);
+}
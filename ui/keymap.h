@@ -0,0 +1,88 @@
+#ifndef _KEYMAP_H_
+#define _KEYMAP_H_
+
+#include "input.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+* Key bindings hashed by (code, modifier).
+* A binding either runs an action or is a prefix of a chord,
+* then the next key is looked up in its own keymap.
+* Zeroed keymap is an empty one.
+*/
+
+#define KEYMAP_INITIAL_CAP 16 /* slots, power of two */
+#define KEYMAP_CHORD_MAX   4  /* keys in the longest chord */
+
+/* Key as it is looked up */
+#define KEYMAP_KEY(code, modifier) ((keymap_key_t)(code) << 8 | (keymap_key_t)(modifier))
+
+typedef uint32_t keymap_key_t;
+
+/* `data` is given on bind, `param` by the dispatcher */
+typedef void (*keymap_action_t)(const keystroke_event_t *const event, void *const data, void *const param);
+
+typedef struct keymap keymap_t;
+
+typedef struct
+{
+    keymap_key_t    key;
+    bool            bound;
+    keymap_action_t action; /* NULL for a chord prefix */
+    void           *data;
+    keymap_t       *chord;  /* bindings that continue the prefix */
+}
+keymap_binding_t;
+
+struct keymap
+{
+    keymap_binding_t *slots; /* open addressing, linear probing */
+    size_t capacity;
+    size_t count;
+};
+
+/*
+* Prefix of a chord typed so far. Keys are kept rather than the keymap
+* they lead to, so rebinding or freeing a scope can't leave it dangling.
+* Zeroed one is no chord.
+*/
+typedef struct
+{
+    keymap_key_t keys[KEYMAP_CHORD_MAX - 1];
+    size_t length;
+}
+keymap_chord_t;
+
+typedef enum
+{
+    KEYMAP_UNBOUND = 0, /* nothing took the key, it goes to the widgets */
+    KEYMAP_HANDLED,
+    KEYMAP_PENDING,     /* prefix of a chord, waiting for the next key */
+}
+keymap_result_t;
+
+void keymap_deinit(keymap_t *const keymap);
+
+/*
+* Binds a sequence of `length` keys (KEYMAP_CHORD_MAX at most),
+* all but the last become chord prefixes.
+* Rebinding replaces the action, a key can't be both an action and a prefix.
+*/
+void keymap_bind(keymap_t *const keymap, const keymap_key_t keys[], const size_t length,
+        keymap_action_t action, void *const data);
+
+const keymap_binding_t *keymap_lookup(const keymap_t *const keymap, const keymap_key_t key);
+
+/*
+* Resolves a keystroke against `scopes`, from the most specific one.
+* `pending` keeps the chord in progress between calls, it is resolved
+* against `scopes` again, a key that does not continue it cancels the chord.
+*/
+keymap_result_t keymap_dispatch(keymap_chord_t *const pending,
+        const keymap_t *const scopes[], const size_t count,
+        const keystroke_event_t *const event, void *const param);
+
+#endif/*_KEYMAP_H_*/
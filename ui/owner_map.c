@@ -0,0 +1,100 @@
+#include "owner_map.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static size_t map_width(const owner_map_t *const map);
+static size_t map_height(const owner_map_t *const map);
+
+
+void owner_map_reset(owner_map_t *const map, const disp_area_t *const area)
+{
+    assert(map);
+    assert(area);
+
+    map->area = *area;
+    if (IS_INVALID_AREA(area) || area->first.x > area->second.x || area->first.y > area->second.y)
+    {
+        map->area = INVALID_AREA;
+        return;
+    }
+
+    const size_t cells = map_width(map) * map_height(map);
+    if (cells > map->capacity)
+    {
+        free(map->cells);
+        map->cells = malloc(cells * sizeof(owner_id_t));
+        if (!map->cells)
+        {
+            perror("owner map");
+            exit(EXIT_FAILURE);
+        }
+        map->capacity = cells;
+    }
+    memset(map->cells, 0, cells * sizeof(owner_id_t));
+}
+
+
+void owner_map_deinit(owner_map_t *const map)
+{
+    assert(map);
+
+    free(map->cells);
+    *map = (owner_map_t){0};
+}
+
+
+void owner_map_fill(owner_map_t *const map, const disp_area_t *const area, const owner_id_t id)
+{
+    assert(map);
+    assert(area);
+
+    if (IS_INVALID_AREA(area) || IS_INVALID_AREA(&map->area) || !map->cells) return;
+
+    /* clip to the map */
+    const uint16_t left  = area->first.x > map->area.first.x ? area->first.x : map->area.first.x;
+    const uint16_t top   = area->first.y > map->area.first.y ? area->first.y : map->area.first.y;
+    const uint16_t right = area->second.x < map->area.second.x ? area->second.x : map->area.second.x;
+    const uint16_t bot   = area->second.y < map->area.second.y ? area->second.y : map->area.second.y;
+    if (left > right || top > bot) return;
+
+    const size_t width = map_width(map);
+    for (size_t y = top; y <= bot; ++y)
+    {
+        owner_id_t *row = map->cells + (y - map->area.first.y) * width;
+        for (size_t x = left; x <= right; ++x)
+        {
+            row[x - map->area.first.x] = id;
+        }
+    }
+}
+
+
+owner_id_t owner_map_get(const owner_map_t *const map, const disp_pos_t pos)
+{
+    assert(map);
+
+    if (!map->cells || IS_INVALID_AREA(&map->area)) return OWNER_NONE;
+    if (pos.x < map->area.first.x || pos.x > map->area.second.x
+     || pos.y < map->area.first.y || pos.y > map->area.second.y)
+    {
+        return OWNER_NONE;
+    }
+
+    return map->cells[(size_t)(pos.y - map->area.first.y) * map_width(map)
+                    + (pos.x - map->area.first.x)];
+}
+
+
+static size_t map_width(const owner_map_t *const map)
+{
+    return (size_t)map->area.second.x - map->area.first.x + 1;
+}
+
+
+static size_t map_height(const owner_map_t *const map)
+{
+    return (size_t)map->area.second.y - map->area.first.y + 1;
+}
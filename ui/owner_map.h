@@ -0,0 +1,36 @@
+#ifndef _OWNER_MAP_H_
+#define _OWNER_MAP_H_
+
+#include "display_types.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+* Per-cell owner ids over an area of the screen,
+* rebuilt on recalculate so that hit-testing is a single lookup.
+* Ids start from 1, zero means no owner.
+*/
+
+#define OWNER_NONE 0
+
+typedef uint16_t owner_id_t;
+
+typedef struct
+{
+    owner_id_t *cells;
+    disp_area_t area;   /* covered by cells, row major */
+    size_t      capacity;
+}
+owner_map_t;
+
+/* Covers `area` with no owners, keeps the storage when it is big enough */
+void owner_map_reset(owner_map_t *const map, const disp_area_t *const area);
+void owner_map_deinit(owner_map_t *const map);
+
+/* Claims cells of `area` that are on the map, previous owner is overwritten */
+void owner_map_fill(owner_map_t *const map, const disp_area_t *const area, const owner_id_t id);
+
+owner_id_t owner_map_get(const owner_map_t *const map, const disp_pos_t pos);
+
+#endif/*_OWNER_MAP_H_*/
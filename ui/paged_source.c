@@ -0,0 +1,436 @@
+#include "paged_source.h"
+#include "logger.h"
+#include "utils.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#define NO_PAGE ((size_t) -1)
+
+typedef enum
+{
+    PAGE_EMPTY = 0,
+    PAGE_QUEUED,  /* waits for the worker */
+    PAGE_LOADING, /* items belong to the worker */
+    PAGE_READY,
+}
+page_state_t;
+
+typedef struct
+{
+    size_t       page;   /* held by the slot, NO_PAGE if none */
+    page_state_t state;  /* guarded by the lock */
+    unsigned long long used;   /* request tick, least recently used is evicted */
+    unsigned long long queued; /* order for the worker */
+    bool         fresh;  /* became ready since the last on_loaded, guarded by the lock */
+    char        *items;
+}
+page_slot_t;
+
+struct paged_source
+{
+    paged_source_opts_t opts;
+    input_t         *input;
+    interior_t      *view;
+    int             eventfd;   /* worker -> input loop */
+    pthread_t       worker;
+    pthread_mutex_t *lock;     /* behind a pointer, the const render path takes it too */
+    pthread_cond_t  wake;
+    bool            stop;
+    page_slot_t     *slots;    /* opts.cache_pages of them */
+    unsigned long long tick;
+    unsigned long long enqueued;
+    size_t          last_first; /* of the previous request */
+    size_t          last_count;
+    int             direction;  /* of scrolling, 1 or -1 */
+    bool            starved;    /* a page found no slot, the window is requested again on load */
+};
+
+static size_t get_amount(const void *const data);
+static void request_range(void *const data, const size_t first, const size_t count);
+static void attach_view(void *const data, interior_t *const view);
+static void render_item(display_t *const display, const interior_area_t *const area,
+        const void *const data, const size_t limit, const size_t index, const bool hovered);
+
+static void enqueue(paged_source_t *const source, const size_t page,
+        const size_t keep_first, const size_t keep_last);
+static page_slot_t *find_slot(const paged_source_t *const source, const size_t page);
+static page_slot_t *next_queued(const paged_source_t *const source);
+static void *work(void *const data);
+static void on_loaded(input_t *const input, const int fd, ring_t *const queue,
+        const bool closed, void *const data);
+
+
+paged_source_t *paged_source_create(input_t *const input, const paged_source_opts_t *const opts)
+{
+    assert(input);
+    assert(opts);
+    assert(opts->fetch);
+    assert(opts->render);
+    assert(opts->item_size);
+
+    paged_source_t *source = calloc(1, sizeof(paged_source_t));
+    if (!source)
+    {
+        perror("paged_source_create");
+        exit(EXIT_FAILURE);
+    }
+
+    *source = (paged_source_t){
+        .opts = *opts,
+        .input = input,
+        .direction = 1,
+    };
+    if (!source->opts.page_size)   source->opts.page_size = PAGED_SOURCE_PAGE_SIZE;
+    if (!source->opts.cache_pages) source->opts.cache_pages = PAGED_SOURCE_CACHE_PAGES;
+    if (!source->opts.prefetch)    source->opts.prefetch = PAGED_SOURCE_PREFETCH;
+
+    source->slots = calloc(source->opts.cache_pages, sizeof(page_slot_t));
+    if (!source->slots)
+    {
+        perror("paged_source_create");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t s = 0; s < source->opts.cache_pages; ++s)
+    {
+        source->slots[s].page = NO_PAGE;
+        source->slots[s].items = malloc(source->opts.page_size * source->opts.item_size);
+        if (!source->slots[s].items)
+        {
+            perror("paged_source_create");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    source->eventfd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (-1 == source->eventfd)
+    {
+        perror("eventfd");
+        exit(EXIT_FAILURE);
+    }
+    if (INPUT_SUCCESS != input_watch_fd(input, source->eventfd, 0, on_loaded, source))
+    {
+        S_LOG(LOGGER_CRITICAL, "Failed to watch paged source eventfd!\n");
+        exit(EXIT_FAILURE);
+    }
+
+    source->lock = malloc(sizeof(pthread_mutex_t));
+    if (!source->lock)
+    {
+        perror("paged_source_create");
+        exit(EXIT_FAILURE);
+    }
+    pthread_mutex_init(source->lock, NULL);
+    pthread_cond_init(&source->wake, NULL);
+    /* signals are for the main thread, the worker must not take SIGWINCH from the signalfd */
+    sigset_t all, previous;
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &previous);
+    const int started = pthread_create(&source->worker, NULL, work, source);
+    pthread_sigmask(SIG_SETMASK, &previous, NULL);
+    if (0 != started)
+    {
+        S_LOG(LOGGER_CRITICAL, "Failed to start paged source worker!\n");
+        exit(EXIT_FAILURE);
+    }
+
+    return source;
+}
+
+
+void paged_source_destroy(paged_source_t *const source)
+{
+    assert(source);
+
+    pthread_mutex_lock(source->lock);
+    source->stop = true;
+    pthread_cond_signal(&source->wake);
+    pthread_mutex_unlock(source->lock);
+    pthread_join(source->worker, NULL);
+
+    input_unwatch_fd(source->input, source->eventfd);
+    close(source->eventfd);
+    pthread_cond_destroy(&source->wake);
+    pthread_mutex_destroy(source->lock);
+    free(source->lock);
+
+    for (size_t s = 0; s < source->opts.cache_pages; ++s)
+    {
+        free(source->slots[s].items);
+    }
+    free(source->slots);
+    free(source);
+}
+
+
+data_source_t paged_source_data_source(paged_source_t *const source)
+{
+    return (data_source_t){
+        .data = source,
+        .get_amount = get_amount,
+        .render = render_item,
+        .request = request_range,
+        .attach = attach_view,
+    };
+}
+
+
+static size_t get_amount(const void *const data)
+{
+    const paged_source_t *source = data;
+    return source->opts.amount;
+}
+
+
+/*
+* Queues pages of the range, nearest first, then the ones ahead of scrolling.
+* Queued pages that went out of the range are dropped, so that the worker
+* does not spend time on what was scrolled past.
+*/
+static void request_range(void *const data, const size_t first, const size_t count)
+{
+    paged_source_t *source = data;
+    const size_t page_size = source->opts.page_size;
+    if (!count || !source->opts.amount) return;
+
+    if (first != source->last_first)
+    {
+        source->direction = (first > source->last_first) ? 1 : -1;
+        source->last_first = first;
+    }
+    source->last_count = count;
+
+    const size_t last_page = (source->opts.amount - 1) / page_size;
+    size_t keep_first = first / page_size;
+    size_t keep_last = (first + count - 1) / page_size;
+    const size_t visible_first = keep_first;
+    const size_t visible_last = keep_last;
+
+    if (source->direction > 0)
+    {
+        keep_last += source->opts.prefetch;
+        if (keep_last > last_page) keep_last = last_page;
+        if (keep_last - keep_first >= source->opts.cache_pages)
+        {
+            keep_last = keep_first + source->opts.cache_pages - 1;
+        }
+    }
+    else
+    {
+        keep_first = (keep_first > source->opts.prefetch) ? keep_first - source->opts.prefetch : 0;
+        if (keep_last - keep_first >= source->opts.cache_pages)
+        {
+            keep_first = keep_last - source->opts.cache_pages + 1;
+        }
+    }
+
+    pthread_mutex_lock(source->lock);
+    ++source->tick;
+    source->starved = false;
+
+    for (size_t s = 0; s < source->opts.cache_pages; ++s)
+    {
+        page_slot_t *slot = &source->slots[s];
+        if (PAGE_QUEUED == slot->state && (slot->page < keep_first || slot->page > keep_last))
+        {
+            *slot = (page_slot_t){ .page = NO_PAGE, .items = slot->items };
+        }
+    }
+
+    /* visible pages first */
+    for (size_t page = visible_first; page <= visible_last && page <= keep_last; ++page)
+    {
+        if (page >= keep_first) enqueue(source, page, keep_first, keep_last);
+    }
+    if (source->direction > 0)
+    {
+        for (size_t page = visible_last + 1; page <= keep_last; ++page)
+        {
+            enqueue(source, page, keep_first, keep_last);
+        }
+    }
+    else
+    {
+        for (size_t page = visible_first; page-- > keep_first;)
+        {
+            enqueue(source, page, keep_first, keep_last);
+        }
+    }
+
+    if (next_queued(source)) pthread_cond_signal(&source->wake);
+    pthread_mutex_unlock(source->lock);
+}
+
+
+static void attach_view(void *const data, interior_t *const view)
+{
+    paged_source_t *source = data;
+    source->view = view;
+}
+
+
+/*
+* A slot leaves READY only in enqueue, which runs on the input thread as this
+* does, so items of a slot seen READY stay put without holding the lock.
+*/
+static void render_item(display_t *const display, const interior_area_t *const area,
+        const void *const data, const size_t limit, const size_t index, const bool hovered)
+{
+    UNUSED(limit);
+    const paged_source_t *source = data;
+    const size_t page_size = source->opts.page_size;
+    const void *item = NULL;
+
+    pthread_mutex_lock(source->lock);
+    const page_slot_t *slot = find_slot(source, index / page_size);
+    if (slot && PAGE_READY == slot->state)
+    {
+        item = slot->items + (index % page_size) * source->opts.item_size;
+    }
+    pthread_mutex_unlock(source->lock);
+
+    source->opts.render(display, area, item, index, hovered, source->opts.store);
+}
+
+
+/*
+* 'request_range' helper, called with the lock held.
+* Pages of [keep_first, keep_last] are never evicted for each other.
+*/
+static void enqueue(paged_source_t *const source, const size_t page,
+        const size_t keep_first, const size_t keep_last)
+{
+    page_slot_t *slot = find_slot(source, page);
+    if (slot)
+    {
+        slot->used = source->tick;
+        return;
+    }
+
+    page_slot_t *victim = NULL;
+    for (size_t s = 0; s < source->opts.cache_pages; ++s)
+    {
+        page_slot_t *candidate = &source->slots[s];
+        const bool busy = PAGE_QUEUED == candidate->state || PAGE_LOADING == candidate->state;
+        const bool kept = NO_PAGE != candidate->page
+            && candidate->page >= keep_first && candidate->page <= keep_last;
+
+        if (busy || kept) continue;
+        if (!victim || candidate->used < victim->used) victim = candidate;
+    }
+    if (!victim)
+    {
+        source->starved = true;
+        return;
+    }
+
+    victim->page = page;
+    victim->state = PAGE_QUEUED;
+    victim->fresh = false;
+    victim->used = source->tick;
+    victim->queued = ++source->enqueued;
+}
+
+
+static page_slot_t *find_slot(const paged_source_t *const source, const size_t page)
+{
+    for (size_t s = 0; s < source->opts.cache_pages; ++s)
+    {
+        if (page == source->slots[s].page) return &source->slots[s];
+    }
+    return NULL;
+}
+
+
+/* Earliest queued slot, called with the lock held */
+static page_slot_t *next_queued(const paged_source_t *const source)
+{
+    page_slot_t *next = NULL;
+    for (size_t s = 0; s < source->opts.cache_pages; ++s)
+    {
+        page_slot_t *slot = &source->slots[s];
+        if (PAGE_QUEUED == slot->state && (!next || slot->queued < next->queued))
+        {
+            next = slot;
+        }
+    }
+    return next;
+}
+
+
+static void *work(void *const data)
+{
+    paged_source_t *source = data;
+    const size_t page_size = source->opts.page_size;
+
+    pthread_mutex_lock(source->lock);
+    while (!source->stop)
+    {
+        page_slot_t *slot = next_queued(source);
+        if (!slot)
+        {
+            pthread_cond_wait(&source->wake, source->lock);
+            continue;
+        }
+
+        slot->state = PAGE_LOADING;
+        const size_t first = slot->page * page_size;
+        const size_t left = source->opts.amount - first;
+        pthread_mutex_unlock(source->lock);
+
+        source->opts.fetch(source->opts.store, first, (left < page_size) ? left : page_size, slot->items);
+
+        pthread_mutex_lock(source->lock);
+        slot->state = PAGE_READY;
+        slot->fresh = true;
+
+        const uint64_t one = 1;
+        (void) !write(source->eventfd, &one, sizeof(one));
+    }
+    pthread_mutex_unlock(source->lock);
+
+    return NULL;
+}
+
+
+/*
+* Input loop side of the eventfd, counter value does not matter,
+* pages that became ready are looked up instead.
+*/
+static void on_loaded(input_t *const input, const int fd, ring_t *const queue,
+        const bool closed, void *const data)
+{
+    UNUSED(input, fd);
+    paged_source_t *source = data;
+    const size_t page_size = source->opts.page_size;
+
+    ring_consume(queue, ring_avail_to_read(queue));
+    if (closed) return;
+
+    bool shown = false;
+    pthread_mutex_lock(source->lock);
+    for (size_t s = 0; s < source->opts.cache_pages; ++s)
+    {
+        page_slot_t *slot = &source->slots[s];
+        if (PAGE_READY != slot->state || !slot->fresh) continue;
+
+        slot->fresh = false;
+        if (source->view && view_invalidate_items(source->view, slot->page * page_size, page_size))
+        {
+            shown = true;
+        }
+    }
+    const bool starved = source->starved;
+    pthread_mutex_unlock(source->lock);
+
+    /* a slot may be free by now */
+    if (starved) request_range(source, source->last_first, source->last_count);
+
+    if (shown && source->opts.loaded) source->opts.loaded(source->opts.loaded_data);
+}
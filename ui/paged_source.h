@@ -0,0 +1,56 @@
+#ifndef _PAGED_SOURCE_H_
+#define _PAGED_SOURCE_H_
+
+#include "input.h"
+#include "interior.h"
+#include "view.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+* Data source for the view that loads items page by page on a worker thread,
+* so that a slow store never blocks the input loop.
+* Loaded pages are announced through an eventfd watched by the input,
+* the view repaints only their items in view. Items that are still
+* in flight are rendered as placeholders.
+*/
+
+#define PAGED_SOURCE_PAGE_SIZE   64 /* items, default */
+#define PAGED_SOURCE_CACHE_PAGES 16 /* default */
+#define PAGED_SOURCE_PREFETCH    2  /* pages ahead of the scroll direction, default */
+
+/*
+* Runs on the worker, must be thread safe with respect to `store`.
+* Fills `items` with `count` items starting from `first`.
+*/
+typedef void (*paged_fetch_t)(void *const store, const size_t first, const size_t count, void *const items);
+
+/* `item` is NULL while it is being loaded */
+typedef void (*paged_render_t)(display_t *const display, const interior_area_t *const area,
+        const void *const item, const size_t index, const bool hovered, void *const store);
+
+typedef struct
+{
+    void           *store;
+    size_t         amount;      /* of items in the store */
+    size_t         item_size;
+    size_t         page_size;   /* zero picks PAGED_SOURCE_PAGE_SIZE */
+    size_t         cache_pages; /* zero picks PAGED_SOURCE_CACHE_PAGES */
+    size_t         prefetch;    /* zero picks PAGED_SOURCE_PREFETCH */
+    paged_fetch_t  fetch;
+    paged_render_t render;
+    void (*loaded)(void *const data); /* optional, on the input thread after a page in view arrives */
+    void           *loaded_data;
+}
+paged_source_opts_t;
+
+typedef struct paged_source paged_source_t;
+
+paged_source_t *paged_source_create(input_t *const input, const paged_source_opts_t *const opts);
+void paged_source_destroy(paged_source_t *const source);
+
+/* To be put into view_opts_t */
+data_source_t paged_source_data_source(paged_source_t *const source);
+
+#endif/*_PAGED_SOURCE_H_*/
@@ -54,6 +54,7 @@ void panel_deinit(panel_t *const panel)
 {
     assert(panel);
 
+    keymap_deinit(&panel->keymap);
     interior_deinit(panel->interior);
 }
 
@@ -62,7 +63,11 @@ void panel_recalculate(panel_t *panel, disp_area_t *const bounds)
 {
     panel->area = calc_panel_area(&panel->layout, bounds);
 
-    if (IS_INVALID_AREA(&panel->area)) return;
+    if (IS_INVALID_AREA(&panel->area))
+    {
+        interior_validate(panel->interior); /* nothing to render */
+        return;
+    }
 
     interior_recalculate(panel->interior, &panel->area);
 }
@@ -75,6 +80,7 @@ void panel_render(const panel_t *panel, display_t *const display)
 
     // dont render panel if has no valid area
     if (IS_INVALID_AREA(&panel->area)) return;
+    if (!panel_is_dirty(panel)) return;
 
     // disp_area_t panel_area = panel->area;
     // border_set_t border = {._ = L"╭╮╯╰│─"};
@@ -83,6 +89,42 @@ void panel_render(const panel_t *panel, display_t *const display)
     // panel_draw_title(panel, display);
 
     interior_render(panel->interior, display);
+    interior_validate(panel->interior);
+}
+
+
+void panel_erase(const panel_t *panel, display_t *const display)
+{
+    assert(panel);
+    assert(display);
+
+    if (!panel_is_dirty(panel)) return;
+
+    display_clear_area(display, panel->interior->dirty);
+}
+
+
+void panel_invalidate(panel_t *const panel)
+{
+    interior_invalidate(panel->interior);
+}
+
+
+void panel_invalidate_area(panel_t *const panel, const disp_area_t area)
+{
+    interior_invalidate_area(panel->interior, area);
+}
+
+
+bool panel_is_dirty(const panel_t *const panel)
+{
+    return !IS_INVALID_AREA(&panel->area) && interior_is_dirty(panel->interior);
+}
+
+
+disp_area_t panel_dirty_area(const panel_t *const panel)
+{
+    return panel_is_dirty(panel) ? panel->interior->dirty : INVALID_AREA;
 }
 
 
@@ -128,6 +170,12 @@ void panel_keystroke(panel_t *const panel, const keystroke_event_t *const event)
 }
 
 
+void panel_paste(panel_t *const panel, const paste_event_t *const event)
+{
+    interior_paste(panel->interior, event);
+}
+
+
 void panel_recv_focus(panel_t *const panel)
 {
     interior_recv_focus(panel->interior);
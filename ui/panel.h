@@ -4,6 +4,7 @@
 #include "display.h"
 #include "input.h"
 #include "interior.h"
+#include "keymap.h"
 
 typedef struct
 {
@@ -19,6 +20,7 @@ typedef struct panel
     panel_layout_t layout;
     disp_area_t    area;
     interior_t     *interior;
+    keymap_t       keymap; /* checked after the interior one */
 }
 panel_t;
 
@@ -34,6 +36,7 @@ panel_opts_t;
 void panel_init(panel_t *const panel, const panel_opts_t *const opts, Arena *const arena);
 void panel_deinit(panel_t *const panel);
 void panel_render(const panel_t *panel, display_t *const display);
+void panel_erase(const panel_t *panel, display_t *const display);
 void panel_recalculate(panel_t *panel, disp_area_t *const bounds);
 void panel_enter(panel_t *const panel, const disp_pos_t pos);
 void panel_hover(panel_t *const panel, const disp_pos_t pos);
@@ -42,11 +45,18 @@ void panel_scroll(panel_t *const panel, const disp_pos_t pos, const int directio
 void panel_press(panel_t *const panel, const disp_pos_t pos, const int btn);
 void panel_release(panel_t *const panel, const disp_pos_t pos, const int btn);
 void panel_keystroke(panel_t *const panel, const keystroke_event_t *const event);
+void panel_paste(panel_t *const panel, const paste_event_t *const event);
 void panel_special_key(panel_t *const panel, const keystroke_event_t *const event);
 void panel_navigation(panel_t *const panel, const keystroke_event_t *const event);
 void panel_recv_focus(panel_t *const panel);
 void panel_lost_focus(panel_t *const panel);
 
+/* Dirty state is kept by the interior, panel is rendered when it has some */
+void panel_invalidate(panel_t *const panel);
+void panel_invalidate_area(panel_t *const panel, const disp_area_t area);
+bool panel_is_dirty(const panel_t *const panel);
+disp_area_t panel_dirty_area(const panel_t *const panel);
+
 /* TODO: add other event handlers by panel interface */
 
 #endif // _PANEL_H_
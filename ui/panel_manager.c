@@ -18,6 +18,9 @@
 static int delete_panel(void *const panel, void *const _);
 static int recalc_panel(void *const panel, void *const bounds);
 static int render_panel(const void *const panel, void *const display);
+static int erase_panel(const void *const panel, void *const display);
+static void spread_dirty(panel_manager_t *const pm);
+static void map_owners(panel_manager_t *const pm, const disp_area_t *const bounds);
 
 
 void pm_init(panel_manager_t *const pm)
@@ -50,6 +53,9 @@ void pm_delete_panels(panel_manager_t *const pm)
 
     dynarr_transform(pm->panels, delete_panel, NULL);
     dynarr_remove_range(&pm->panels, 0, dynarr_size(pm->panels));
+    owner_map_reset(&pm->owners, &INVALID_AREA);
+    pm->last_hovered = NULL;
+    pm->focused = NULL;
 }
 
 
@@ -58,7 +64,9 @@ void pm_recalculate(panel_manager_t *const pm, disp_area_t *const bounds)
     assert(pm);
     assert(bounds);
 
+    const disp_area_t screen = *bounds; /* panels take their space out of bounds */
     dynarr_transform(pm->panels, recalc_panel, bounds);
+    map_owners(pm, &screen);
 }
 
 
@@ -116,24 +124,22 @@ void pm_keystroke(panel_manager_t *const pm, const keystroke_event_t *const even
 }
 
 
-panel_t *pm_peek_panel(panel_manager_t *const pm, const disp_pos_t pos)
+void pm_paste(panel_manager_t *const pm, const paste_event_t *const event)
 {
     assert(pm);
+    panel_t *focused = pm_get_focused_panel(pm);
+    if (focused) panel_paste(focused, event);
+}
 
-    const size_t panels_count = dynarr_size(pm->panels);
-
-    for (size_t pi = 0; pi < panels_count; ++pi)
-    {
-        panel_t *panel = dynarr_get(pm->panels, pi);
 
-        if ( pos.x >= panel->area.first.x && pos.x <= panel->area.second.x
-          && pos.y >= panel->area.first.y && pos.y <= panel->area.second.y)
-        {
-            return panel;
-        }
-    }
+panel_t *pm_peek_panel(panel_manager_t *const pm, const disp_pos_t pos)
+{
+    assert(pm);
 
-    return NULL;
+    const owner_id_t owner = owner_map_get(&pm->owners, pos);
+    return (OWNER_NONE != owner)
+        ? dynarr_get(pm->panels, owner - 1)
+        : NULL;
 }
 
 
@@ -173,20 +179,51 @@ void pm_focus_prev_panel(panel_manager_t *const pm)
 }
 
 
-void pm_render(const panel_manager_t *const pm, display_t *const display)
+void pm_render(panel_manager_t *const pm, display_t *const display)
 {
     assert(pm);
 
+    /* all dirty areas are cleared before any is drawn, panels may overlap */
+    dynarr_foreach(pm->panels, erase_panel, display);
+    spread_dirty(pm);
     dynarr_foreach(pm->panels, render_panel, display);
 }
 
 
+bool pm_is_dirty(const panel_manager_t *const pm)
+{
+    assert(pm);
+
+    const size_t panels_count = dynarr_size(pm->panels);
+    for (size_t pi = 0; pi < panels_count; ++pi)
+    {
+        if (panel_is_dirty(dynarr_get(pm->panels, pi))) return true;
+    }
+    return false;
+}
+
+
+/* Something drawn over the panels is gone, they repaint what it covered */
+void pm_invalidate_area(panel_manager_t *const pm, const disp_area_t area)
+{
+    assert(pm);
+
+    const size_t panels_count = dynarr_size(pm->panels);
+    for (size_t pi = 0; pi < panels_count; ++pi)
+    {
+        panel_t *panel = dynarr_get(pm->panels, pi);
+        if (!IS_INVALID_AREA(&panel->area)) panel_invalidate_area(panel, area);
+    }
+}
+
+
 void pm_deinit(panel_manager_t *const pm)
 {
     assert(pm);
     pm_delete_panels(pm);
 
     dynarr_destroy(pm->panels);
+    owner_map_deinit(&pm->owners);
     arena_free(&pm->arena);
 }
 
@@ -211,3 +248,50 @@ static int render_panel(const void *const panel, void *const display)
     panel_render(panel, display);
     return 0;
 }
+
+
+static int erase_panel(const void *const panel, void *const display)
+{
+    panel_erase(panel, display);
+    return 0;
+}
+
+
+/*
+* A panel repaints what the others erase or repaint over it. In render order
+* each takes the dirty areas of the rest, clipped to its own area: the ones
+* before it are final by then, the ones after it still cover what is erased.
+*/
+static void spread_dirty(panel_manager_t *const pm)
+{
+    const size_t panels_count = dynarr_size(pm->panels);
+    for (size_t pi = 0; pi < panels_count; ++pi)
+    {
+        panel_t *panel = dynarr_get(pm->panels, pi);
+        if (IS_INVALID_AREA(&panel->area)) continue;
+
+        for (size_t oi = 0; oi < panels_count; ++oi)
+        {
+            if (oi == pi) continue;
+
+            const disp_area_t overlap = disp_area_intersection(
+                    panel_dirty_area(dynarr_get(pm->panels, oi)), panel->area);
+            if (!IS_INVALID_AREA(&overlap)) panel_invalidate_area(panel, overlap);
+        }
+    }
+}
+
+
+/* Earlier panels are on top, so they are mapped last */
+static void map_owners(panel_manager_t *const pm, const disp_area_t *const bounds)
+{
+    const size_t panels_count = dynarr_size(pm->panels);
+    assert(panels_count < (owner_id_t) -1);
+
+    owner_map_reset(&pm->owners, bounds);
+    for (size_t pi = panels_count; pi > 0; --pi)
+    {
+        const panel_t *panel = dynarr_get(pm->panels, pi - 1);
+        owner_map_fill(&pm->owners, &panel->area, pi);
+    }
+}
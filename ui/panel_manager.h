@@ -3,6 +3,7 @@
 
 #include "dynarr.h"
 #include "arena.h"
+#include "owner_map.h"
 #include "panel.h"
 
 typedef struct
@@ -11,6 +12,7 @@ typedef struct
     dynarr_t *panels; /* storage for panel references */
     panel_t  *last_hovered;
     panel_t  *focused; /* panel that has focus (type events will go there) */
+    owner_map_t owners; /* panel index + 1 for each cell, hit-testing */
 }
 panel_manager_t;
 
@@ -23,13 +25,16 @@ void pm_press(panel_manager_t *const pm, const disp_pos_t pos, const int btn);
 void pm_release(panel_manager_t *const pm, const disp_pos_t pos, const int btn);
 void pm_scroll(panel_manager_t *const pm, const disp_pos_t pos, const int dir);
 void pm_keystroke(panel_manager_t *const pm, const keystroke_event_t *const event);
+void pm_paste(panel_manager_t *const pm, const paste_event_t *const event);
 panel_t *pm_peek_panel(panel_manager_t *const pm, const disp_pos_t pos);
 panel_t *pm_get_focused_panel(panel_manager_t *const pm);
 void pm_set_focused_panel(panel_manager_t *const pm, panel_t *const panel);
 void pm_clear_focus(panel_manager_t *const pm);
 void pm_focus_next_panel(panel_manager_t *const pm);
 void pm_focus_prev_panel(panel_manager_t *const pm);
-void pm_render(const panel_manager_t *const pm, display_t *const display);
+void pm_render(panel_manager_t *const pm, display_t *const display);
+bool pm_is_dirty(const panel_manager_t *const pm);
+void pm_invalidate_area(panel_manager_t *const pm, const disp_area_t area);
 void pm_deinit(panel_manager_t *const pm);
 
 #endif/*_PANEL_MANAGER_H_*/
@@ -6,8 +6,13 @@
 #include "interior.h"
 #include "layout.h"
 #include "logger.h"
+#include "utf8.h"
 #include "utils.h"
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
 typedef enum
 {
     TIF_INACTIVE = 0,
@@ -19,7 +24,7 @@ text_input_state_t;
 /* only extended part */
 typedef struct
 {
-    dynarr_t *text;
+    dynarr_t *text; /* of uint32_t codepoints */
     size_t    caret;
     size_t    offset;
     text_input_state_t state;
@@ -48,6 +53,8 @@ static void text_input_field_scroll(interior_t *const base, const disp_pos_t pos
 static void text_input_field_press(interior_t *const base, const disp_pos_t pos, const int btn);
 static void text_input_field_release(interior_t *const base, const disp_pos_t pos, const int btn);
 static void text_input_field_keystroke(interior_t *const interior, const keystroke_event_t *const event);
+static void text_input_field_paste(interior_t *const interior, const paste_event_t *const event);
+static bool is_control(const uint32_t ch);
 
 
 interior_interface_t text_input_field_interior_get_impl(void)
@@ -65,6 +72,7 @@ interior_interface_t text_input_field_interior_get_impl(void)
         .press       = text_input_field_press,
         .release     = text_input_field_release,
         .keystroke   = text_input_field_keystroke,
+        .paste       = text_input_field_paste,
         .recv_focus  = text_input_field_recv_focus,
         .lost_focus  = text_input_field_lost_focus,
     };
@@ -85,7 +93,7 @@ static void text_input_field_init(interior_t *const base, void *opts, Arena *con
     text_input_field_t *interior = (text_input_field_t*)base;
 
     interior->text_input_field = (text_input_field_slice_t) {
-        .text = dynarr_create(.element_size = sizeof(char))
+        .text = dynarr_create(.element_size = sizeof(uint32_t))
     };
 }
 
@@ -144,17 +152,21 @@ static void text_input_field_render(const interior_t *base, display_t *const dis
         display_set_char(display, '>', pos);
     }
 
-    // Draw centered text content
-    disp_area_t text_area = area->area;
-    text_area.first.x += 1;
-    display_draw_string_aligned(display,
-            (text_length - interior->text_input_field.offset) >= window_length
-                ? window_length
-                : (text_length - interior->text_input_field.offset),
-            vector_data(interior->text_input_field.text) + interior->text_input_field.offset,
-            text_area,
-            styles[0],
-            LAYOUT_ALIGN_LEFT_V_CENTER);
+    // Draw text content, vertically centered
+    const disp_pos_t text_pos = {
+        .x = area->area.first.x + 1,
+        .y = area->area.first.y + (disp_area_height(area->area)) / 2
+    };
+    if (text_length > interior->text_input_field.offset)
+    {
+        display_draw_codepoints(display,
+                (text_length - interior->text_input_field.offset) >= window_length
+                    ? window_length
+                    : (text_length - interior->text_input_field.offset),
+                dynarr_get(interior->text_input_field.text, interior->text_input_field.offset),
+                text_pos,
+                styles[0]);
+    }
 
     // Do not draw caret when inactive
     if (TIF_INACTIVE == interior->text_input_field.state) return;
@@ -191,6 +203,7 @@ static void text_input_field_recv_focus(interior_t *const base)
     UNUSED(base);
     text_input_field_t *interior = (text_input_field_t*)base;
     interior->text_input_field.state = TIF_ACTIVE;
+    interior_invalidate(base);
 }
 
 
@@ -199,6 +212,7 @@ static void text_input_field_lost_focus(interior_t *const base)
     UNUSED(base);
     text_input_field_t *interior = (text_input_field_t*)base;
     interior->text_input_field.state = TIF_INACTIVE;
+    interior_invalidate(base);
 }
 
 
@@ -243,20 +257,24 @@ static void text_input_field_keystroke(interior_t *const base, const keystroke_e
     switch (event->code)
     {
         case KEY_LEFT:
-            if (interior->text_input_field.caret > 0)
+            for (unsigned int i = 0; i < event->repeat; ++i)
             {
-                --interior->text_input_field.caret;
-            }
-            else if (interior->text_input_field.offset > 0)
-            {
-                --interior->text_input_field.offset;
+                if (interior->text_input_field.caret > 0)
+                {
+                    --interior->text_input_field.caret;
+                }
+                else if (interior->text_input_field.offset > 0)
+                {
+                    --interior->text_input_field.offset;
+                }
             }
             break;
         case KEY_RIGHT:
-        {
-            const size_t after_offset = text_length - interior->text_input_field.offset;
-            if (interior->text_input_field.caret < after_offset)
+            for (unsigned int i = 0; i < event->repeat; ++i)
             {
+                const size_t after_offset = text_length - interior->text_input_field.offset;
+                if (interior->text_input_field.caret >= after_offset) break;
+
                 if (interior->text_input_field.caret < window_length)
                 {
                     ++interior->text_input_field.caret;
@@ -267,7 +285,6 @@ static void text_input_field_keystroke(interior_t *const base, const keystroke_e
                 }
             }
             break;
-        }
         case KEY_BACKSPACE:
         {
             const bool has_chars_from_left = (text_length > 0)
@@ -300,16 +317,17 @@ static void text_input_field_keystroke(interior_t *const base, const keystroke_e
         }
         case KEY_RETURN:
             // TODO: something else
-            S_LOG(LOGGER_DEBUG, "Entered text: \"%s\"\n", vector_data(interior->text_input_field.text));
+            S_LOG(LOGGER_DEBUG, "Entered text of %zu characters\n", text_length);
             break;
         case KEY_ESC:
             break;
         default:
             if (event->stroke)
             {
+                const uint32_t ch = event->stroke;
                 dynarr_insert(&interior->text_input_field.text,
                         interior->text_input_field.caret + interior->text_input_field.offset,
-                        &event->stroke);
+                        &ch);
 
                 if (interior->text_input_field.caret < window_length)
                 {
@@ -321,4 +339,57 @@ static void text_input_field_keystroke(interior_t *const base, const keystroke_e
                 }
             }
     }
+
+    interior_invalidate(base);
+}
+
+
+/*
+* Inserts printable part of the paste at the caret in one go,
+* the field is single line, so control characters are dropped.
+*/
+static void text_input_field_paste(interior_t *const base, const paste_event_t *const event)
+{
+    text_input_field_t *interior = (text_input_field_t*) base;
+    if (!event->size) return;
+
+    uint32_t *decoded = malloc(event->size * sizeof(uint32_t));
+    if (!decoded)
+    {
+        perror("text_input_field_paste");
+        exit(EXIT_FAILURE);
+    }
+    const size_t length = utf8_decode(event->data, event->size, decoded);
+
+    size_t printable = 0;
+    for (size_t i = 0; i < length; ++i)
+    {
+        if (!is_control(decoded[i])) decoded[printable++] = decoded[i];
+    }
+
+    const size_t pos = interior->text_input_field.offset + interior->text_input_field.caret;
+    if (!printable
+        || dynarr_spread_insert(&interior->text_input_field.text, pos, printable, TMP_REF(uint32_t, 0)))
+    {
+        free(decoded);
+        return;
+    }
+    memcpy(dynarr_get(interior->text_input_field.text, pos), decoded, printable * sizeof(uint32_t));
+    free(decoded);
+
+    const interior_area_t *area = dynarr_first(interior->interior.layout.areas);
+    const size_t width = disp_area_width(area->area);
+    const size_t window_length =  width <= 2 ? 0 : width - 2;
+
+    /* caret stays right after the inserted text */
+    const size_t caret_pos = pos + printable;
+    interior->text_input_field.caret = caret_pos < window_length ? caret_pos : window_length;
+    interior->text_input_field.offset = caret_pos - interior->text_input_field.caret;
+    interior_invalidate(base);
+}
+
+
+static bool is_control(const uint32_t ch)
+{
+    return ch < 0x20 || (0x7f <= ch && ch < 0xa0);
 }
@@ -1,6 +1,7 @@
 #include "ui.h"
 #include "display_types.h"
 #include "input.h"
+#include "keymap.h"
 #include "logger.h"
 #include "panel.h"
 #include "display.h"
@@ -21,6 +22,13 @@ static void ui_scroll(const mouse_event_t *const, void *const);
 // Keyboard
 //
 static void ui_keystroke(const keystroke_event_t *const, void *const);
+static void ui_paste(const paste_event_t *const, void *const);
+static void ui_quit(const keystroke_event_t *const, void *const, void *const);
+
+static void request_frame(ui_t *const ui);
+static void arm_chord_timer(ui_t *const ui);
+static void chord_expired(void *const data);
+static void render_chord_mark(ui_t *const ui, display_t *const display);
 
 static input_hooks_t hooks_init(void)
 {
@@ -34,16 +42,23 @@ static input_hooks_t hooks_init(void)
         .on_drag_end = ui_drag_end,
         .on_scroll = ui_scroll,
         .on_keystroke = ui_keystroke,
+        .on_paste = ui_paste,
     };
 }
 
 
-ui_t ui_init(void)
+ui_t ui_init(input_t *const input)
 {
+    assert(input);
+
     ui_t ui = {
         .hooks = hooks_init(),
+        .timers = &input->timers,
+        .chord_mark = INVALID_AREA,
+        .invalidated = true,
     };
     pm_init(&ui.pm);
+    ui_bind(&ui, &(keymap_key_t){KEYMAP_KEY(KEY_D, MOD_CTRL)}, 1, ui_quit, NULL);
     return ui;
 }
 
@@ -51,7 +66,9 @@ ui_t ui_init(void)
 void ui_deinit(ui_t *const ui)
 {
     assert(ui);
+    if (ui->chord_timer) timers_cancel(ui->timers, ui->chord_timer);
     pm_deinit(&ui->pm);
+    keymap_deinit(&ui->keymap);
 }
 
 
@@ -65,24 +82,45 @@ void ui_recalculate(ui_t *const ui, const display_t *const display)
         .second = {display->size.x - 1, display->size.y - 1}
     };
     pm_recalculate(&ui->pm, &bounds);
+    ui->relayout = true;
+    ui_invalidate(ui);
 }
 
 
-void ui_resize_hook(const display_t *const display, void *data)
+void ui_render(ui_t *const ui, display_t *const display)
 {
+    assert(ui);
     assert(display);
-    assert(data);
 
-    ui_recalculate((ui_t*)data, display);
+    if (ui->relayout)
+    {
+        /* shrunk or hidden panels leave cells that no one repaints */
+        ui->relayout = false;
+        ui->chord_mark = INVALID_AREA;
+        display_clear(display);
+    }
+    else if (!ui->chord.length && !IS_INVALID_AREA(&ui->chord_mark))
+    {
+        /* the mark may be over cells that no panel covers */
+        display_clear_area(display, ui->chord_mark);
+        pm_invalidate_area(&ui->pm, ui->chord_mark);
+        ui->chord_mark = INVALID_AREA;
+    }
+
+    pm_render(&ui->pm, display);
+
+    if (ui->chord.length)
+    {
+        render_chord_mark(ui, display);
+    }
 }
 
 
-void ui_render(const ui_t *const ui, display_t *const display)
+void ui_invalidate(ui_t *const ui)
 {
     assert(ui);
-    assert(display);
 
-    pm_render(&ui->pm, display);
+    ui->invalidated = true;
 }
 
 
@@ -92,6 +130,16 @@ void ui_add_panel(ui_t *const ui, const panel_opts_t *const opts)
     assert(opts);
 
     pm_add_panel(&ui->pm, opts);
+    ui_invalidate(ui);
+}
+
+
+void ui_bind(ui_t *const ui, const keymap_key_t keys[], const size_t length,
+        keymap_action_t action, void *const data)
+{
+    assert(ui);
+
+    keymap_bind(&ui->keymap, keys, length, action, data);
 }
 
 
@@ -102,6 +150,7 @@ static void ui_hover(const mouse_event_t *const hover, void *const param)
         hover->position.x, hover->position.y);
 
     pm_hover(&ui->pm, hover->position);
+    request_frame(ui);
 }
 
 
@@ -112,6 +161,7 @@ static void ui_press(const mouse_event_t *const press, void *const param)
         press->mouse_button, press->position.x, press->position.y);
 
     pm_press(&ui->pm, press->position, press->mouse_button);
+    request_frame(ui);
 }
 
 
@@ -122,6 +172,7 @@ static void ui_release(const mouse_event_t *const press, void *const param)
         press->mouse_button, press->position.x, press->position.y);
 
     pm_release(&ui->pm, press->position, press->mouse_button);
+    request_frame(ui);
 }
 
 
@@ -161,6 +212,7 @@ static void ui_scroll(const mouse_event_t *const scroll, void *const param)
         scroll->mouse_button, scroll->position.x, scroll->position.y);
 
     pm_scroll(&ui->pm, scroll->position, scroll->mouse_button);
+    request_frame(ui);
 }
 
 
@@ -170,11 +222,85 @@ static void ui_keystroke(const keystroke_event_t *const event, void *const param
 
     S_LOG(LOGGER_DEBUG, "UI::keystroke %x(%d)\n mod:%x\n", event->stroke, event->code, event->modifier);
 
-    if (KEY_D == event->code && MOD_CTRL == event->modifier)
+    if (event->released) return; /* widgets act on presses */
+
+    /* from the focused interior out to the global scope */
+    const panel_t *focused = pm_get_focused_panel(&ui->pm);
+    const keymap_t *scopes[] = {
+        focused ? &focused->interior->keymap : NULL,
+        focused ? &focused->keymap : NULL,
+        &ui->keymap,
+    };
+
+    if (KEYMAP_UNBOUND == keymap_dispatch(&ui->chord, scopes, sizeof(scopes) / sizeof(*scopes), event, ui))
     {
-        ui->exit_requested = true;
-        return;
+        pm_keystroke(&ui->pm, event);
     }
+    arm_chord_timer(ui);
+    request_frame(ui);
+}
+
+
+static void ui_quit(const keystroke_event_t *const event, void *const data, void *const param)
+{
+    UNUSED(event, data);
+    ui_t *ui = param;
+    ui->exit_requested = true;
+}
+
+
+static void ui_paste(const paste_event_t *const event, void *const param)
+{
+    ui_t *ui = param;
+
+    S_LOG(LOGGER_DEBUG, "UI::paste %zu bytes\n", event->size);
+
+    pm_paste(&ui->pm, event);
+    request_frame(ui);
+}
+
+
+/* Frame is needed only when some panel got dirty */
+static void request_frame(ui_t *const ui)
+{
+    const bool marked = !IS_INVALID_AREA(&ui->chord_mark);
+    if (pm_is_dirty(&ui->pm) || marked != (ui->chord.length > 0))
+    {
+        ui_invalidate(ui);
+    }
+}
+
+
+/* Each key of a chord gives the same time for the next one */
+static void arm_chord_timer(ui_t *const ui)
+{
+    if (ui->chord_timer)
+    {
+        timers_cancel(ui->timers, ui->chord_timer);
+        ui->chord_timer = 0;
+    }
+    if (ui->chord.length)
+    {
+        ui->chord_timer = timers_add(ui->timers, UI_CHORD_TIMEOUT, 0, chord_expired, ui);
+    }
+}
+
+
+static void chord_expired(void *const data)
+{
+    ui_t *ui = data;
+    ui->chord_timer = 0;
+    ui->chord = (keymap_chord_t){0};
+    request_frame(ui);
+}
+
+
+static void render_chord_mark(ui_t *const ui, display_t *const display)
+{
+    const unsigned int width = sizeof(UI_CHORD_MARK) - 1;
+    if (display->size.x < width || !display->size.y) return;
 
-    pm_keystroke(&ui->pm, event);
+    const disp_pos_t pos = { .x = display->size.x - width, .y = display->size.y - 1 };
+    display_draw_string(display, width, UI_CHORD_MARK, pos, UI_CHORD_STYLE);
+    ui->chord_mark = (disp_area_t){ .first = pos, .second = { display->size.x - 1, pos.y } };
 }
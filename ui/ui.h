@@ -2,29 +2,45 @@
 #define _UI_H_
 
 #include "input.h"
+#include "keymap.h"
 #include "sparse.h"
 #include "logger.h"
 #include "panel_manager.h"
 #include "panel.h"
 
+#define UI_CHORD_TIMEOUT 1500 /* ms to type the rest of a chord */
+#define UI_CHORD_MARK    " ... " /* shown at the bottom right while a chord is pending */
+#define UI_CHORD_STYLE   ((style_t){ .seq = ESC"[7m" })
+
 typedef struct
 {
     input_hooks_t hooks;
     panel_manager_t pm;
+    keymap_t keymap;        /* global bindings, the last scope to look in */
+    keymap_chord_t chord;   /* prefix of a chord being typed */
+    timers_t *timers;       /* of the input, for the chord timeout */
+    timer_id_t chord_timer;
+    disp_area_t chord_mark; /* where the chord mark is drawn, INVALID_AREA if not */
     bool exit_requested;
+    bool invalidated; /* has to be rendered again */
+    bool relayout;    /* panels moved, the next frame starts from a clear screen */
 }
 ui_t;
 
-ui_t ui_init(void);
+ui_t ui_init(input_t *const input);
 void ui_deinit(ui_t *const ui);
 
 void ui_recalculate(ui_t *const ui, const display_t *const display);
 
-void ui_resize_hook(const display_t *const display, void *const data);
+void ui_render(ui_t *const ui, display_t *const display);
 
-void ui_render(const ui_t *const ui, display_t *const display);
+void ui_invalidate(ui_t *const ui);
 
 void ui_add_panel(ui_t *const ui, const panel_opts_t *const opts);
 
+/* Global binding, `keys` longer than one make a chord, param of the action is the ui */
+void ui_bind(ui_t *const ui, const keymap_key_t keys[], const size_t length,
+        keymap_action_t action, void *const data);
+
 
 #endif /* _UI_H_ */
@@ -5,6 +5,11 @@
 #include "interior_layout.h"
 #include "input.h"
 
+#include <stdio.h>
+#include <stdlib.h>
+
+#define VIEW_NO_ROW ((size_t) -1)
+
 /*
 * Contains only view extention members,
 * allows for designated initialization
@@ -12,8 +17,18 @@
 typedef struct
 {
     data_source_t source;
+    view_mode_t mode;
+    uint16_t row_height;
+    size_t amount;  /* of items in the source, cached */
+    size_t visible; /* items that fit, updated on recalculate */
     size_t scroll_offset;
-    interior_area_t *last_hovered;
+    interior_area_t *last_hovered; /* areas mode */
+    size_t hovered_row;            /* list mode, VIEW_NO_ROW if none */
+    char  *rows;          /* items of the window given by get_range */
+    size_t rows_capacity; /* in items */
+    size_t rows_first;    /* index of the first one */
+    size_t rows_count;
+    bool   rows_valid;    /* window is loaded, until it moves or the source changes */
 }
 view_slice_t;
 
@@ -35,12 +50,31 @@ static void view_interior_leave(interior_t *const base, const disp_pos_t pos);
 static void view_interior_scroll(interior_t *const base, const disp_pos_t pos, const int dir);
 static void view_interior_press(interior_t *const base, const disp_pos_t pos, const int btn);
 static void view_interior_release(interior_t *const base, const disp_pos_t pos, const int btn);
+static void view_interior_keystroke(interior_t *const base, const keystroke_event_t *const event);
+
+static void render_areas(const view_t *const interior, display_t *const display);
+static void render_list(const view_t *const interior, display_t *const display);
+static void render_scrollbar(const view_t *const interior, display_t *const display);
 
-static void adjust_scroll_position(view_t *const interior, const size_t limit);
+static void scroll_to(view_t *const interior, const size_t offset);
+static void scroll_up(view_t *const interior, const size_t amount);
+static void scroll_down(view_t *const interior, const size_t amount);
+static size_t max_scroll_offset(const view_t *const interior);
+
+static const interior_area_t *list_area(const view_t *const interior);
+static bool has_scrollbar(const view_t *const interior);
+static disp_area_t row_area(const view_t *const interior, const size_t row);
+static size_t row_at(const view_t *const interior, const disp_pos_t pos);
+static void invalidate_row(view_t *const interior, const size_t row);
 
 static size_t data_source_get_amount(const data_source_t *const source);
+static void data_source_request(const data_source_t *const source, const size_t first, const size_t count);
+static void load_window(view_t *const interior);
+static void request_window(const view_t *const interior);
+static size_t window_count(const view_t *const interior);
+static void fetch_rows(view_t *const interior, const size_t first, const size_t count);
 
-static void data_source_render(const data_source_t *const source,
+static void data_source_render(const view_t *const interior,
         display_t *const display, const interior_area_t *const area,
         const size_t limit, const size_t index, const bool hovered);
 
@@ -62,10 +96,62 @@ interior_interface_t view_interior_get_impl(void)
         .scroll      = view_interior_scroll,
         .press       = view_interior_press,
         .release     = view_interior_release,
+        .keystroke   = view_interior_keystroke,
+        .paste       = interior_paste_stub,
+
+        /* ignored events: */
+        .recv_focus  = interior_focus_stub,
+        .lost_focus  = interior_focus_stub,
     };
 }
 
 
+void view_reload(interior_t *const base)
+{
+    view_t *interior = (view_t*)base;
+
+    interior->view.amount = data_source_get_amount(&interior->view.source);
+    interior->view.rows_valid = false;
+    scroll_to(interior, interior->view.scroll_offset);
+    load_window(interior);
+    interior_invalidate(base);
+}
+
+
+bool view_invalidate_items(interior_t *const base, const size_t first, const size_t count)
+{
+    view_t *interior = (view_t*)base;
+    const size_t offset = interior->view.scroll_offset;
+    const size_t end = offset + window_count(interior);
+
+    const size_t from = (first > offset) ? first : offset;
+    const size_t to = (first + count < end) ? first + count : end;
+    if (from >= to) return false;
+
+    if (interior->view.source.get_range)
+    {
+        fetch_rows(interior, offset, window_count(interior));
+    }
+
+    if (VIEW_MODE_LIST == interior->view.mode)
+    {
+        interior_invalidate_area(base, disp_area_union(
+                row_area(interior, from - offset), row_area(interior, to - 1 - offset)));
+        return true;
+    }
+
+    size_t index = offset;
+    const size_t areas_count = dynarr_size(base->layout.areas);
+    for (size_t ai = 0; ai < areas_count && index < to; ++ai)
+    {
+        const interior_area_t *area = dynarr_get(base->layout.areas, ai);
+        if (!interior_area_is_visible(area)) continue;
+        if (index++ >= from) interior_invalidate_area(base, area->area);
+    }
+    return true;
+}
+
+
 static void *view_interior_alloc(Arena *arena)
 {
     return arena_alloc(arena, sizeof(view_t));
@@ -80,14 +166,24 @@ static void view_interior_init(interior_t *const base, void *opts, Arena *const
 
     interior->view = (view_slice_t){
         .source = view_opts->source,
+        .mode = view_opts->mode,
+        .row_height = view_opts->row_height ? view_opts->row_height : 1,
+        .amount = data_source_get_amount(&view_opts->source),
+        .hovered_row = VIEW_NO_ROW,
         // zero init for the rest of the members
     };
+
+    if (view_opts->source.attach)
+    {
+        view_opts->source.attach(view_opts->source.data, base);
+    }
 }
 
 
 static void view_interior_deinit(interior_t *const base)
 {
-    UNUSED(base);
+    view_t *interior = (view_t*)base;
+    free(interior->view.rows);
 }
 
 
@@ -96,27 +192,35 @@ static void view_interior_recalculate(interior_t *const base, disp_area_t *const
     UNUSED(panel_area);
 
     view_t *interior = (view_t*)base;
-    adjust_scroll_position(interior, 0);
+    if (VIEW_MODE_LIST == interior->view.mode)
+    {
+        const interior_area_t *area = list_area(interior);
+        interior->view.visible = interior_area_is_visible(area)
+            ? disp_area_height(area->area) / interior->view.row_height
+            : 0;
+        interior->view.hovered_row = VIEW_NO_ROW;
+    }
+    else
+    {
+        interior->view.visible = interior_layout_count_valid_areas(&base->layout);
+    }
+    interior->view.rows_valid = false;
+
+    scroll_to(interior, interior->view.scroll_offset);
+    load_window(interior);
 }
 
 
 static void view_interior_render(const interior_t *base, display_t *const display)
 {
-    view_t *interior = (view_t*)base;
+    const view_t *interior = (const view_t*)base;
 
-    const size_t limit = data_source_get_amount(&interior->view.source);
-    const size_t areas_count = dynarr_size(base->layout.areas);
-    for (size_t ai = 0; ai < areas_count; ++ai)
+    if (VIEW_MODE_LIST == interior->view.mode)
     {
-        interior_area_t *area = dynarr_get(base->layout.areas, ai);
-        const bool hovered = (area == interior->view.last_hovered);
-
-        if (interior_area_is_visible(area))
-        {
-            data_source_render(&interior->view.source, display, area,
-                    limit, ai + interior->view.scroll_offset, hovered);
-        }
+        render_list(interior, display);
+        return;
     }
+    render_areas(interior, display);
 }
 
 
@@ -129,8 +233,29 @@ static void view_interior_enter(interior_t *const base, const disp_pos_t pos)
 static void view_interior_hover(interior_t *const base, const disp_pos_t pos)
 {
     view_t *interior = (view_t*)base;
+
+    if (VIEW_MODE_LIST == interior->view.mode)
+    {
+        const size_t row = row_at(interior, pos);
+        if (row != interior->view.hovered_row)
+        {
+            invalidate_row(interior, interior->view.hovered_row);
+            invalidate_row(interior, row);
+            interior->view.hovered_row = row;
+        }
+        return;
+    }
+
     interior_area_t *hovered = interior_layout_peek_area(&base->layout, pos);
-    if (hovered) { interior->view.last_hovered = hovered; }
+    if (hovered && hovered != interior->view.last_hovered)
+    {
+        if (interior->view.last_hovered)
+        {
+            interior_invalidate_area(base, interior->view.last_hovered->area);
+        }
+        interior_invalidate_area(base, hovered->area);
+        interior->view.last_hovered = hovered;
+    }
 }
 
 
@@ -139,8 +264,12 @@ static void view_interior_leave(interior_t *const base, const disp_pos_t pos)
     UNUSED(pos);
     view_t *interior = (view_t*)base;
 
+    invalidate_row(interior, interior->view.hovered_row);
+    interior->view.hovered_row = VIEW_NO_ROW;
+
     if (interior->view.last_hovered)
     {
+        interior_invalidate_area(base, interior->view.last_hovered->area);
         interior->view.last_hovered = NULL;
     }
 }
@@ -151,23 +280,28 @@ static void view_interior_scroll(interior_t *const base, const disp_pos_t pos, c
     UNUSED(pos);
     view_t *interior = (view_t*)base;
 
-    const size_t limit = data_source_get_amount(&interior->view.source);
+    const size_t step = (VIEW_MODE_LIST == interior->view.mode) ? VIEW_WHEEL_STEP : 1;
     if (SCROLL_UP == dir)
     {
-        if (interior->view.scroll_offset == 0) { return; }
-        --interior->view.scroll_offset;
+        scroll_up(interior, step);
         return;
     }
-
-    ++interior->view.scroll_offset;
-
-    adjust_scroll_position(interior, limit);
+    scroll_down(interior, step);
 }
 
 
+/* Press on the scrollbar jumps to the proportional position */
 static void view_interior_press(interior_t *const base, const disp_pos_t pos, const int btn)
 {
-    UNUSED(base, pos, btn);
+    view_t *interior = (view_t*)base;
+    if (MOUSE_1 != btn || !has_scrollbar(interior)) return;
+
+    const disp_area_t area = list_area(interior)->area;
+    if (pos.x != area.second.x) return;
+
+    const size_t track = disp_area_height(area);
+    const size_t at = pos.y - area.first.y;
+    scroll_to(interior, (track > 1) ? max_scroll_offset(interior) * at / (track - 1) : 0);
 }
 
 
@@ -177,30 +311,287 @@ static void view_interior_release(interior_t *const base, const disp_pos_t pos,
 }
 
 
-static void adjust_scroll_position(view_t *const interior, const size_t limit)
+static void view_interior_keystroke(interior_t *const base, const keystroke_event_t *const event)
 {
-    // CACHE? or maybe use last_hovered
-    const size_t valid_areas = interior_layout_count_valid_areas(&interior->interior.layout);
-    const size_t max_scroll_offset = (limit <= valid_areas) ? 0 : limit - valid_areas;
+    view_t *interior = (view_t*)base;
+    const size_t page = interior->view.visible ? interior->view.visible : 1;
+
+    switch (event->code)
+    {
+        case KEY_UP:        scroll_up(interior, event->repeat); break;
+        case KEY_DOWN:      scroll_down(interior, event->repeat); break;
+        case KEY_PAGE_UP:   scroll_up(interior, page * event->repeat); break;
+        case KEY_PAGE_DOWN: scroll_down(interior, page * event->repeat); break;
+        case KEY_HOME:      scroll_to(interior, 0); break;
+        case KEY_END:       scroll_to(interior, max_scroll_offset(interior)); break;
+        default: break;
+    }
+}
+
+
+static void render_areas(const view_t *const interior, display_t *const display)
+{
+    const interior_t *base = &interior->interior;
+    const size_t limit = interior->view.amount;
+
+    /* items go to visible areas only, as many of them are counted in `visible` */
+    size_t index = interior->view.scroll_offset;
+    const size_t areas_count = dynarr_size(base->layout.areas);
+    for (size_t ai = 0; ai < areas_count; ++ai)
+    {
+        interior_area_t *area = dynarr_get(base->layout.areas, ai);
+        if (!interior_area_is_visible(area)) continue;
+
+        const size_t item = index++;
+        const bool hovered = (area == interior->view.last_hovered);
+
+        /* areas that are not dirty still show what they should */
+        const disp_area_t dirty = disp_area_intersection(area->area, base->dirty);
+        if (!IS_INVALID_AREA(&dirty))
+        {
+            data_source_render(interior, display, area, limit, item, hovered);
+        }
+    }
+}
+
+
+/* Only rows in view are rendered, the amount of items does not matter */
+static void render_list(const view_t *const interior, display_t *const display)
+{
+    const interior_area_t *area = list_area(interior);
+    if (!interior_area_is_visible(area)) return;
+
+    const size_t limit = interior->view.amount;
+    const size_t offset = interior->view.scroll_offset;
+    const size_t rows = window_count(interior);
+
+    for (size_t row = 0; row < rows; ++row)
+    {
+        const interior_area_t cell = {
+            .def = area->def,
+            .area = row_area(interior, row),
+        };
+        const disp_area_t dirty = disp_area_intersection(cell.area, interior->interior.dirty);
+        if (IS_INVALID_AREA(&dirty)) continue;
+
+        data_source_render(interior, display, &cell,
+                limit, offset + row, row == interior->view.hovered_row);
+    }
 
-    if (interior->view.scroll_offset >= max_scroll_offset)
+    if (has_scrollbar(interior))
     {
-        interior->view.scroll_offset = max_scroll_offset;
+        render_scrollbar(interior, display);
     }
 }
 
 
+/* Thumb is sized by the visible part of the source and placed by the offset */
+static void render_scrollbar(const view_t *const interior, display_t *const display)
+{
+    const disp_area_t area = list_area(interior)->area;
+    const size_t track = disp_area_height(area);
+    const size_t max_offset = max_scroll_offset(interior);
+
+    size_t thumb = track * interior->view.visible / interior->view.amount;
+    if (thumb < 1) thumb = 1;
+    const size_t thumb_pos = max_offset
+        ? (track - thumb) * interior->view.scroll_offset / max_offset
+        : 0;
+
+    const style_t track_style = {.seq = ESC"[90m"};
+    const style_t thumb_style = {.seq = ESC"[37m"};
+
+    for (size_t y = 0; y < track; ++y)
+    {
+        const disp_pos_t pos = {.x = area.second.x, .y = area.first.y + y};
+        const bool on_thumb = (thumb_pos <= y && y < thumb_pos + thumb);
+
+        display_set_char(display, on_thumb ? L'█' : L'│', pos);
+        display_set_style(display, on_thumb ? thumb_style : track_style, pos);
+    }
+}
+
+
+static void scroll_to(view_t *const interior, const size_t offset)
+{
+    const size_t max_offset = max_scroll_offset(interior);
+    const size_t clamped = (offset > max_offset) ? max_offset : offset;
+
+    if (clamped != interior->view.scroll_offset)
+    {
+        interior->view.scroll_offset = clamped;
+        interior->view.rows_valid = false;
+        load_window(interior);
+        interior_invalidate(&interior->interior);
+    }
+}
+
+
+static void scroll_up(view_t *const interior, const size_t amount)
+{
+    scroll_to(interior, (interior->view.scroll_offset > amount)
+            ? interior->view.scroll_offset - amount
+            : 0);
+}
+
+
+static void scroll_down(view_t *const interior, const size_t amount)
+{
+    const size_t max_offset = max_scroll_offset(interior);
+    scroll_to(interior, (max_offset - interior->view.scroll_offset > amount)
+            ? interior->view.scroll_offset + amount
+            : max_offset);
+}
+
+
+static size_t max_scroll_offset(const view_t *const interior)
+{
+    const size_t limit = interior->view.amount;
+    const size_t visible = interior->view.visible;
+    return (limit <= visible) ? 0 : limit - visible;
+}
+
+
+static const interior_area_t *list_area(const view_t *const interior)
+{
+    return dynarr_first(interior->interior.layout.areas);
+}
+
+
+static bool has_scrollbar(const view_t *const interior)
+{
+    if (VIEW_MODE_LIST != interior->view.mode) return false;
+
+    const interior_area_t *area = list_area(interior);
+    return interior_area_is_visible(area)
+        && disp_area_width(area->area) > 1
+        && interior->view.amount > interior->view.visible;
+}
+
+
+/* Rows are laid from the top of the list area, left of the scrollbar */
+static disp_area_t row_area(const view_t *const interior, const size_t row)
+{
+    const disp_area_t area = list_area(interior)->area;
+    const uint16_t top = area.first.y + row * interior->view.row_height;
+
+    return (disp_area_t){
+        .first = {.x = area.first.x, .y = top},
+        .second = {
+            .x = area.second.x - (has_scrollbar(interior) ? 1 : 0),
+            .y = top + interior->view.row_height - 1,
+        },
+    };
+}
+
+
+static size_t row_at(const view_t *const interior, const disp_pos_t pos)
+{
+    const interior_area_t *area = list_area(interior);
+    if (!interior_area_is_visible(area)) return VIEW_NO_ROW;
+
+    if (pos.x < area->area.first.x || pos.y < area->area.first.y) return VIEW_NO_ROW;
+    if (has_scrollbar(interior) && pos.x >= area->area.second.x) return VIEW_NO_ROW;
+
+    const size_t row = (pos.y - area->area.first.y) / interior->view.row_height;
+    const size_t rows = interior->view.amount - interior->view.scroll_offset;
+    return (row < interior->view.visible && row < rows) ? row : VIEW_NO_ROW;
+}
+
+
+static void invalidate_row(view_t *const interior, const size_t row)
+{
+    if (VIEW_NO_ROW == row) return;
+    interior_invalidate_area(&interior->interior, row_area(interior, row));
+}
+
+
 static size_t data_source_get_amount(const data_source_t *const source)
 {
     return source->get_amount(source->data);
 }
 
 
-static void data_source_render(const data_source_t *const source,
+static void data_source_request(const data_source_t *const source, const size_t first, const size_t count)
+{
+    if (source->request) source->request(source->data, first, count);
+}
+
+
+/*
+* The source learns of the window when it moves and its rows are taken right away,
+* rendering reads them only.
+*/
+static void load_window(view_t *const interior)
+{
+    if (interior->view.rows_valid) return;
+
+    request_window(interior);
+    fetch_rows(interior, interior->view.scroll_offset, window_count(interior));
+    interior->view.rows_valid = true;
+}
+
+
+static void request_window(const view_t *const interior)
+{
+    data_source_request(&interior->view.source, interior->view.scroll_offset, window_count(interior));
+}
+
+
+/* Items in view, the list stops short at the end of the source */
+static size_t window_count(const view_t *const interior)
+{
+    if (VIEW_MODE_LIST != interior->view.mode) return interior->view.visible;
+
+    const size_t left = interior->view.amount - interior->view.scroll_offset;
+    return (left < interior->view.visible) ? left : interior->view.visible;
+}
+
+
+/*
+* Whole window is taken from the source in one call and kept,
+* so that rows rendered again within it do not reach the source.
+*/
+static void fetch_rows(view_t *const interior, const size_t first, const size_t count)
+{
+    const data_source_t *source = &interior->view.source;
+    if (!source->get_range) return;
+
+    if (count > interior->view.rows_capacity)
+    {
+        char *rows = realloc(interior->view.rows, count * source->item_size);
+        if (!rows)
+        {
+            perror("view rows");
+            exit(EXIT_FAILURE);
+        }
+        interior->view.rows = rows;
+        interior->view.rows_capacity = count;
+    }
+
+    interior->view.rows_first = first;
+    interior->view.rows_count = count
+        ? source->get_range(source->data, first, count, interior->view.rows)
+        : 0;
+}
+
+
+static void data_source_render(const view_t *const interior,
         display_t *const display, const interior_area_t *const area,
         const size_t limit, const size_t index, const bool hovered)
 {
-    source->render(display, area, source->data, limit, index, hovered);
+    const data_source_t *source = &interior->view.source;
+    if (!source->get_range)
+    {
+        source->render(display, area, source->data, limit, index, hovered);
+        return;
+    }
+
+    const size_t row = index - interior->view.rows_first;
+    const void *item = (index >= interior->view.rows_first && row < interior->view.rows_count)
+        ? interior->view.rows + row * source->item_size
+        : NULL;
+    source->render_item(display, area, item, index, hovered);
 }
 
 
@@ -3,6 +3,8 @@
 
 #include "interior.h"
 
+#define VIEW_WHEEL_STEP 3 /* rows per scroll event in the list mode */
+
 typedef struct view view_t;
 
 typedef void (*area_render_t)(display_t *const display,
@@ -11,21 +13,72 @@ typedef void (*area_render_t)(display_t *const display,
 
 typedef size_t (*get_amount_t)(const void *const data);
 
+/* Window of items in view, given whenever it moves, asynchronous sources start loading it */
+typedef void (*request_range_t)(void *const data, const size_t first, const size_t count);
+
+/* Gives the source its view, to invalidate when items arrive */
+typedef void (*attach_view_t)(void *const data, interior_t *const view);
+
+/* Copies up to `count` items starting from `first` into `items`, returns how many */
+typedef size_t (*get_range_t)(void *const data, const size_t first, const size_t count, void *const items);
+
+/* `item` is NULL when the source has not given it */
+typedef void (*item_render_t)(display_t *const display, const interior_area_t *const area,
+        const void *const item, const size_t index, const bool hovered);
+
+/*
+* With `get_range` set the view fetches all visible items in one call
+* whenever the window moves, and renders them with `render_item` instead of `render`.
+*/
 typedef struct data_source
 {
-    void          *data;
-    get_amount_t  get_amount;
-    area_render_t render;
+    void            *data;
+    get_amount_t    get_amount;
+    area_render_t   render;
+    request_range_t request;     /* optional */
+    attach_view_t   attach;      /* optional */
+    get_range_t     get_range;   /* optional */
+    item_render_t   render_item;
+    size_t          item_size;
 }
 data_source_t;
 
+typedef enum
+{
+    VIEW_MODE_AREAS = 0, /* an item per layout area */
+    VIEW_MODE_LIST,      /* rows of the first area, as many as fit */
+}
+view_mode_t;
+
 typedef struct
 {
     interior_opts_t interior;
     data_source_t   source;
+    view_mode_t     mode;
+    uint16_t        row_height; /* of the list mode, 1 if not set */
 }
 view_opts_t;
 
+/* Single area over the whole panel, for the list mode */
+#define VIEW_LIST_LAYOUT ((interior_layout_opts_t){ \
+    .columns = 1, \
+    .columns_def = (counted_layout_def_t[]){ \
+        {.amount = 1, .layout = {.size = 100, .size_method = LAYOUT_SIZE_RELATIVE}}, \
+    }, \
+    .rows = 1, \
+    .rows_def = (counted_layout_def_t[]){ \
+        {.amount = 1, .layout = {.size = 100, .size_method = LAYOUT_SIZE_RELATIVE}}, \
+    }, \
+    .areas = 1, \
+    .areas_def = (interior_area_def_t[]){ {{0, 0}, {0, 0}} }, \
+})
+
 interior_interface_t view_interior_get_impl(void);
 
+/* Amount of items is cached, call when the source has changed */
+void view_reload(interior_t *const interior);
+
+/* Repaints items of [first, first + count) that are in view, returns false if none is */
+bool view_invalidate_items(interior_t *const interior, const size_t first, const size_t count);
+
 #endif/*_VIEW_H_*/